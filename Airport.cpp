@@ -13,12 +13,13 @@ using namespace std;
 Airport::Airport()
 {
   m_code = "";      // Airport code (three letters)
-  m_name = "";      // Name of airport
-  m_city = "";      // City of airport
-  m_country = "";   // Country of airport
-  m_north = 0.0;    // North of airport
-  m_west = 0.0;     // West of airport
+  m_name = SYMBOL_EMPTY;    // Name of airport
+  m_city = SYMBOL_EMPTY;    // City of airport
+  m_country = SYMBOL_EMPTY; // Country of airport
+  m_north = ToCoord(0.0); // North of airport
+  m_west = ToCoord(0.0);  // West of airport
   m_next = nullptr; // Airport pointer to next airport
+  m_id = -1;        // Stable catalog id of airport
 }
 // Name: Airport(string, string, string, string, double, double)
 // Overloaded Constructor
@@ -27,7 +28,9 @@ Airport::Airport()
 // Preconditions: None
 // Postconditions: Creates a new airport for use in a Route
 Airport::Airport(string code, string name, string city, string country, double north, double west)
-    : m_code(code), m_name(name), m_city(city), m_country(country), m_north(north), m_west(west)
+    : m_code(code), m_name(SymbolTable::Shared().Intern(name)), m_city(SymbolTable::Shared().Intern(city)),
+      m_country(SymbolTable::Shared().Intern(country)), m_north(ToCoord(north)), m_west(ToCoord(west)),
+      m_next(nullptr), m_id(-1)
 {
 }
 
@@ -50,12 +53,12 @@ string Airport::GetCode()
 }
 
 // Name: GetName()
-// Desc: Returns the name of the airport
+// Desc: Returns the name of the airport (interned, nothing is copied)
 // Preconditions: None
 // Postconditions: Returns the name of the airport
-string Airport::GetName()
+const string &Airport::GetName()
 {
-  return m_name;
+  return SymbolTable::Shared().Text(m_name);
 }
 
 // Name: GetNext()
@@ -73,7 +76,7 @@ Airport *Airport::GetNext()
 // Postconditions: Returns the N coordinates of the port
 double Airport::GetNorth()
 {
-  return m_north;
+  return FromCoord(m_north);
 }
 
 // Name: GetWest()
@@ -82,27 +85,78 @@ double Airport::GetNorth()
 // Postconditions: Returns the W coordinates of the airport
 double Airport::GetWest()
 {
-  return m_west;
+  return FromCoord(m_west);
 }
 
 // Name: GetCity()
-// Desc: Returns the city of where the airport is located
+// Desc: Returns the city of where the airport is located (interned,
+//   nothing is copied)
 // Preconditions: None
 // Postconditions: Returns the city of where the airport is located
-string Airport::GetCity()
+const string &Airport::GetCity()
 {
-  return m_city;
+  return SymbolTable::Shared().Text(m_city);
 }
 
 // Name: GetCountry()
-// Desc: Returns the country of where the airport is located
+// Desc: Returns the country of where the airport is located (interned,
+//   nothing is copied)
 // Preconditions: None
 // Postconditions: Returns the country of where the airport is located
-string Airport::GetCountry()
+const string &Airport::GetCountry()
+{
+  return SymbolTable::Shared().Text(m_country);
+}
+
+// Name: GetNameId() / GetCityId() / GetCountryId()
+// Desc: Return the interned ids of the text (see SymbolTable.h)
+// Preconditions: None
+// Postconditions: Returns m_name, m_city or m_country
+Symbol Airport::GetNameId()
+{
+  return m_name;
+}
+
+Symbol Airport::GetCityId()
+{
+  return m_city;
+}
+
+Symbol Airport::GetCountryId()
 {
   return m_country;
 }
 
+// Name: GetId()
+// Desc: Returns the stable catalog id of the airport
+// Preconditions: None
+// Postconditions: Returns m_id (-1 if the airport was never cataloged)
+int Airport::GetId()
+{
+  return m_id;
+}
+
+// Name: SetId()
+// Desc: Sets the stable catalog id of the airport. Ids are keyed by
+//   airport code and survive catalog reloads
+// Preconditions: None
+// Postconditions: Sets m_id
+void Airport::SetId(int id)
+{
+  m_id = id;
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the heap held by the airport's code. Interned text is
+//   counted once, with the SymbolTable, and the Airport object itself
+//   by whoever allocated it
+// Preconditions: None
+// Postconditions: usage includes the string buffers
+void Airport::AddMemory(MemoryUsage &usage)
+{
+  AddString(usage, m_code);
+}
+
 // Name: SetNext()
 // Desc: Updates the pointer to a new target (either a airport or nullptr)
 // Preconditions: None
@@ -5,6 +5,10 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+
+#include "Coord.h"
+#include "Memory.h"
+#include "SymbolTable.h"
 using namespace std;
 
 class Airport {
@@ -33,10 +37,10 @@ class Airport {
   // Postconditions: Returns the three letter code of the airport
   string GetCode();
   // Name: GetName()
-  // Desc: Returns the name of the airport
+  // Desc: Returns the name of the airport (interned, nothing is copied)
   // Preconditions: None
   // Postconditions: Returns the name of the airport
-  string GetName();
+  const string &GetName();
   // Name: GetNext()
   // Desc: Returns the pointer to the next airport
   // Preconditions: None (may return either airport or nullptr)
@@ -53,15 +57,43 @@ class Airport {
   // Postconditions: Returns the W coordinates of the airport
   double GetWest();
   // Name: GetCity()
-  // Desc: Returns the city of where the airport is located
+  // Desc: Returns the city of where the airport is located (interned,
+  //   nothing is copied)
   // Preconditions: None
   // Postconditions: Returns the city of where the airport is located
-  string GetCity();
+  const string &GetCity();
   // Name: GetCountry()
-  // Desc: Returns the country of where the airport is located
+  // Desc: Returns the country of where the airport is located (interned,
+  //   nothing is copied)
   // Preconditions: None
   // Postconditions: Returns the country of where the airport is located
-  string GetCountry();
+  const string &GetCountry();
+  // Name: GetNameId() / GetCityId() / GetCountryId()
+  // Desc: Return the interned ids of the text (see SymbolTable.h).
+  //   Equal ids mean equal text, so comparing them is one int compare
+  // Preconditions: None
+  // Postconditions: Returns m_name, m_city or m_country
+  Symbol GetNameId();
+  Symbol GetCityId();
+  Symbol GetCountryId();
+  // Name: GetId()
+  // Desc: Returns the stable catalog id of the airport
+  // Preconditions: None
+  // Postconditions: Returns m_id (-1 if the airport was never cataloged)
+  int GetId();
+  // Name: SetId()
+  // Desc: Sets the stable catalog id of the airport. Ids are keyed by
+  //   airport code and survive catalog reloads
+  // Preconditions: None
+  // Postconditions: Sets m_id
+  void SetId(int id);
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the heap held by the airport's code. Interned text is
+  //   counted once, with the SymbolTable, and the Airport object itself
+  //   by whoever allocated it
+  // Preconditions: None
+  // Postconditions: usage includes the string buffers
+  void AddMemory(MemoryUsage &usage);
   // Name: SetNext()
   // Desc: Updates the pointer to a new target (either a airport or nullptr)
   // Preconditions: None
@@ -74,17 +106,18 @@ class Airport {
   // Postconditions: Returns ostream populated with Airport's name and city
   // **PROVIDED** Do not edit
   friend ostream &operator<< (ostream &output, Airport &myAirport){
-    output << myAirport.m_name << ", " << myAirport.m_city;
+    output << myAirport.GetName() << ", " << myAirport.GetCity();
     return output;
   }
 private:
   string m_code; //Airport code (three letters)
-  string m_name; //Name of airport
-  string m_city; //City of airport
-  string m_country; //Country of airport
-  double m_north; //North of airport
-  double m_west; //West of airport
+  Symbol m_name; //Name of airport (interned in SymbolTable::Shared)
+  Symbol m_city; //City of airport (interned)
+  Symbol m_country; //Country of airport (interned)
+  Coord m_north; //North of airport (see Coord.h)
+  Coord m_west; //West of airport (see Coord.h)
   Airport *m_next; //Airport pointer to next airport
+  int m_id; //Stable catalog id of airport
 };
 
 #endif
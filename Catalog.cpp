@@ -0,0 +1,501 @@
+/*****************************************
+** File:    Catalog.cpp
+** Description: This file implements the catalog snapshot that holds every airport read from the data file
+***********************************************/
+
+#include "Catalog.h"
+#include <chrono>
+using namespace std;
+
+// Name: GridRow(double) / GridColumn(double)
+// Desc: Maps a coordinate to its one degree grid row or column
+// Preconditions: None
+// Postconditions: Returns a row in [0, GRID_ROWS) or a column in
+//   [0, GRID_COLUMNS), longitudes wrap around
+static int GridRow(double north)
+{
+  int row = static_cast<int>(floor(north + 90.0));
+  return row < 0 ? 0 : (row >= GRID_ROWS ? GRID_ROWS - 1 : row);
+}
+
+static int GridColumn(double west)
+{
+  int column = static_cast<int>(floor(west + 180.0)) % GRID_COLUMNS;
+  return column < 0 ? column + GRID_COLUMNS : column;
+}
+
+// Name: GridCell(double, double)
+// Desc: Maps a coordinate to its cell in m_grid
+// Preconditions: None
+// Postconditions: Returns the row major cell index
+static int GridCell(double north, double west)
+{
+  return GridRow(north) * GRID_COLUMNS + GridColumn(west);
+}
+
+// Name: LineHash(string&)
+// Desc: 64 bit FNV-1a hash of a line of the airport file
+// Preconditions: None
+// Postconditions: Returns the hash
+static uint64_t LineHash(const string &line)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < line.size(); i++)
+  {
+    hash = (hash ^ static_cast<unsigned char>(line[i])) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Name: Catalog() - Default Constructor
+// Desc: Builds a new empty catalog snapshot
+// Preconditions: None
+// Postconditions: Creates an empty catalog with generation 0
+Catalog::Catalog() : m_nextId(0), m_generation(0), m_searchMillis(-1.0), m_gridMillis(-1.0)
+{
+  m_report.m_added = 0;
+  m_report.m_removed = 0;
+  m_report.m_changed = 0;
+  m_report.m_unchanged = 0;
+  m_report.m_millis = 0.0;
+}
+
+// Name: ~Catalog() - Destructor
+// Desc: Deallocates every airport owned by the snapshot
+// Preconditions: No reader still holds this snapshot
+// Postconditions: All airports are deleted
+Catalog::~Catalog()
+{
+  for (size_t i = 0; i < m_airports.size(); i++)
+  {
+    delete m_airports[i];
+  }
+  m_airports.clear();
+}
+
+// Name: Load(string, Catalog*)
+// Desc: Reads a file of airports (code,name,city,country,north,west).
+//   If a previous snapshot is given, lines that are identical to the
+//   previous snapshot (same hash, then the same fields as its airport)
+//   are copied instead of interned again, and every code
+//   keeps the id it had before. New codes get fresh ids.
+//   Reading stops at the first empty line. The search index and grid
+//   are left for BuildIndexes or first use
+// Preconditions: previous is either nullptr or a fully built snapshot
+// Postconditions: Returns false if the file could not be opened.
+//   Otherwise the snapshot is populated and m_report describes the diff
+bool Catalog::Load(string fileName, Catalog *previous)
+{
+  ifstream file(fileName);
+  if (!file.is_open()) // file failed to open
+  {
+    cerr << "Unable to open file: " << fileName << endl;
+    return false;
+  }
+  Load(file, previous);
+  file.close();
+  return true;
+}
+
+// Name: Load(istream&, Catalog*)
+// Desc: Load from lines that are already open (a shard's share of the
+//   file, for example). Works the same as Load(string, Catalog*)
+// Preconditions: previous is either nullptr or a fully built snapshot
+// Postconditions: The snapshot is populated, returns true
+bool Catalog::Load(istream &input, Catalog *previous)
+{
+  auto startTime = chrono::steady_clock::now();
+
+  // Carry the id table forward so codes keep their ids across reloads
+  if (previous != nullptr)
+  {
+    m_ids = previous->m_ids;
+    m_nextId = previous->m_nextId;
+    m_generation = previous->m_generation;
+  }
+  m_generation++;
+
+  string line; // used to store each line read from the file
+  while (getline(input, line) && !line.empty())
+  {
+    string code = line.substr(0, line.find(','));
+    if (m_codeIndex.count(code) > 0)
+    {
+      continue; // a duplicate code keeps the first entry
+    }
+
+    uint64_t hash = LineHash(line);
+    Airport *airport = nullptr;
+    if (previous != nullptr)
+    {
+      int oldIndex = previous->FindCode(code);
+      if (oldIndex >= 0 && previous->m_lineHashes[oldIndex] == hash &&
+          previous->Unchanged(line, oldIndex))
+      {
+        // Unchanged line, copy the airport instead of interning its text again
+        airport = new Airport(*previous->m_airports[oldIndex]);
+        m_report.m_unchanged++;
+      }
+      else if (oldIndex >= 0)
+      {
+        m_report.m_changed++;
+      }
+      else
+      {
+        m_report.m_added++;
+      }
+    }
+    if (airport == nullptr)
+    {
+      airport = new Airport(ParseAirport(line));
+    }
+    AddAirport(code, hash, airport);
+  }
+
+  if (previous != nullptr)
+  {
+    // Every code of the old snapshot that did not show up again was removed
+    for (int i = 0; i < previous->GetSize(); i++)
+    {
+      if (m_codeIndex.count(previous->m_airports[i]->GetCode()) == 0)
+      {
+        m_report.m_removed++;
+      }
+    }
+  }
+  else
+  {
+    m_report.m_added = m_airports.size();
+  }
+
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - startTime;
+  m_report.m_millis = elapsed.count();
+  return true;
+}
+
+// Name: Load(FeedStream&, function)
+// Desc: Loads the airports of a feed that keep accepts, a window at a
+//   time, building each Airport from its parsed FeedAirport
+// Preconditions: The catalog is empty
+// Postconditions: The snapshot is populated, returns true
+bool Catalog::Load(FeedStream &stream, const function<bool(const FeedAirport &)> &keep)
+{
+  auto startTime = chrono::steady_clock::now();
+  m_generation++;
+  while (stream.NextWindow())
+  {
+    vector<FeedAirport> &airports = stream.GetAirports();
+    for (size_t i = 0; i < airports.size(); i++)
+    {
+      FeedAirport &parsed = airports[i];
+      if (!keep(parsed) || m_codeIndex.count(parsed.m_code) > 0)
+      {
+        continue; // a duplicate code keeps the first entry
+      }
+      Airport *airport = new Airport(parsed.m_code, parsed.m_name, parsed.m_city, parsed.m_country,
+                                     parsed.m_north, parsed.m_west);
+      AddAirport(parsed.m_code, LineHash(stream.GetLines()[i]), airport);
+    }
+  }
+  m_report.m_added = m_airports.size();
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - startTime;
+  m_report.m_millis = elapsed.count();
+  return true;
+}
+
+// Name: Unchanged(string&, int)
+// Desc: Tells whether a line with the same hash as the airport at
+//   oldIndex holds the same fields (a 64 bit hash alone could collide)
+// Preconditions: oldIndex is a position in this snapshot
+// Postconditions: Returns true if the airport can be reused for line
+bool Catalog::Unchanged(const string &line, int oldIndex)
+{
+  FeedAirport parsed;
+  try
+  {
+    ParseFeedAirport(line, parsed); // plain strings, nothing is interned
+  }
+  catch (const exception &)
+  {
+    return false; // ParseAirport reports it
+  }
+  Airport *old = m_airports[oldIndex];
+  return parsed.m_code == old->GetCode() && parsed.m_name == old->GetName() && parsed.m_city == old->GetCity() &&
+         parsed.m_country == old->GetCountry() && FromCoord(ToCoord(parsed.m_north)) == old->GetNorth() &&
+         FromCoord(ToCoord(parsed.m_west)) == old->GetWest();
+}
+
+// Name: AddAirport(string&, uint64_t, Airport*)
+// Desc: Appends a parsed airport, giving its code an id (the same one
+//   as before if the code was ever seen)
+// Preconditions: code is not in m_codeIndex yet
+// Postconditions: The snapshot owns airport
+void Catalog::AddAirport(const string &code, uint64_t lineHash, Airport *airport)
+{
+  // Ids are keyed by code so stored routes can find the airport again
+  auto found = m_ids.find(code);
+  if (found == m_ids.end())
+  {
+    found = m_ids.insert(make_pair(code, m_nextId++)).first;
+  }
+  airport->SetId(found->second);
+
+  m_codeIndex[code] = m_airports.size();
+  m_idIndex[found->second] = m_airports.size();
+  m_airports.push_back(airport);
+  m_lineHashes.push_back(lineHash);
+}
+
+// Name: BuildIndexes()
+// Desc: Builds the search index and then the grid unless they are
+//   built already
+// Preconditions: Load was called
+// Postconditions: Both indexes are built
+void Catalog::BuildIndexes()
+{
+  call_once(m_searchOnce, &Catalog::BuildSearch, this);
+  call_once(m_gridOnce, &Catalog::BuildGrid, this);
+}
+
+// Name: GetSearchMillis() / GetGridMillis()
+// Desc: Return how long the search index and the grid took to build
+// Preconditions: None
+// Postconditions: Returns the milliseconds, or -1 if not built yet
+double Catalog::GetSearchMillis()
+{
+  return m_searchMillis;
+}
+
+double Catalog::GetGridMillis()
+{
+  return m_gridMillis;
+}
+
+// Name: BuildSearch()
+// Desc: Indexes the code, city, name and country of every airport
+// Preconditions: Load was called
+// Postconditions: m_search is finished, m_searchMillis is set last
+void Catalog::BuildSearch()
+{
+  auto startTime = chrono::steady_clock::now();
+  for (size_t i = 0; i < m_airports.size(); i++)
+  {
+    m_search.Add(i, m_airports[i]->GetCode(), WEIGHT_CODE);
+    m_search.Add(i, m_airports[i]->GetCity(), WEIGHT_CITY);
+    m_search.Add(i, m_airports[i]->GetName(), WEIGHT_NAME);
+    m_search.Add(i, m_airports[i]->GetCountry(), WEIGHT_COUNTRY);
+  }
+  m_search.Finish();
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - startTime;
+  m_searchMillis = elapsed.count(); // AddMemory reads m_search only once this is set
+}
+
+// Name: BuildGrid()
+// Desc: Buckets the airports into one degree cells for box queries
+// Preconditions: Load was called
+// Postconditions: m_grid is filled, m_gridMillis is set last
+void Catalog::BuildGrid()
+{
+  auto startTime = chrono::steady_clock::now();
+  m_grid.assign(GRID_ROWS * GRID_COLUMNS, vector<int>());
+  for (size_t i = 0; i < m_airports.size(); i++)
+  {
+    m_grid[GridCell(m_airports[i]->GetNorth(), m_airports[i]->GetWest())].push_back(i);
+  }
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - startTime;
+  m_gridMillis = elapsed.count();
+}
+
+// Name: GetSize()
+// Desc: Returns the number of airports in the snapshot
+// Preconditions: None
+// Postconditions: Returns m_airports.size()
+int Catalog::GetSize()
+{
+  return static_cast<int>(m_airports.size());
+}
+
+// Name: GetAirport(int)
+// Desc: Returns the airport at a position in the snapshot
+// Preconditions: None
+// Postconditions: Returns the airport or nullptr if out of range
+Airport *Catalog::GetAirport(int index)
+{
+  if (index < 0 || index >= GetSize())
+  {
+    return nullptr;
+  }
+  return m_airports[index];
+}
+
+// Name: FindCode(string)
+// Desc: Looks up an airport by its three letter code
+// Preconditions: None
+// Postconditions: Returns the index of the airport or -1
+int Catalog::FindCode(string code)
+{
+  auto found = m_codeIndex.find(code);
+  if (found == m_codeIndex.end())
+  {
+    return -1;
+  }
+  return found->second;
+}
+
+// Name: FindId(int)
+// Desc: Looks up an airport by its stable id
+// Preconditions: None
+// Postconditions: Returns the airport or nullptr if the id is not
+//   in this snapshot (for example it was removed by a reload)
+Airport *Catalog::FindId(int id)
+{
+  auto found = m_idIndex.find(id);
+  if (found == m_idIndex.end())
+  {
+    return nullptr;
+  }
+  return m_airports[found->second];
+}
+
+// Name: Search(string, int)
+// Desc: Ranked prefix and typo tolerant search over the code, name,
+//   city and country of every airport in the snapshot
+// Preconditions: Load was called
+// Postconditions: Returns at most limit matches, best first. Each
+//   m_index is a position usable with GetAirport
+vector<SearchMatch> Catalog::Search(string query, int limit)
+{
+  call_once(m_searchOnce, &Catalog::BuildSearch, this);
+  return m_search.Search(query, limit);
+}
+
+// Name: InBox(double, double, double, double)
+// Desc: Returns every airport within northSpan degrees of north and
+//   westSpan degrees of west, wrapping across the 180th meridian.
+//   Only the grid cells that overlap the box are visited
+// Preconditions: Load was called
+// Postconditions: Returns airport indexes (candidates for an exact
+//   distance check by the caller)
+vector<int> Catalog::InBox(double north, double west, double northSpan, double westSpan)
+{
+  call_once(m_gridOnce, &Catalog::BuildGrid, this);
+  vector<int> found;
+  int firstRow = GridRow(north - northSpan);
+  int lastRow = GridRow(north + northSpan);
+
+  // A box wider than the globe just visits every column once
+  int columns = GRID_COLUMNS;
+  int firstColumn = 0;
+  if (westSpan < 180.0)
+  {
+    firstColumn = GridColumn(west - westSpan);
+    columns = static_cast<int>(floor(west + westSpan) - floor(west - westSpan)) + 1;
+    if (columns > GRID_COLUMNS)
+    {
+      columns = GRID_COLUMNS;
+    }
+  }
+
+  for (int row = firstRow; row <= lastRow; row++)
+  {
+    for (int step = 0; step < columns; step++)
+    {
+      vector<int> &cell = m_grid[row * GRID_COLUMNS + (firstColumn + step) % GRID_COLUMNS];
+      found.insert(found.end(), cell.begin(), cell.end());
+    }
+  }
+  return found;
+}
+
+// Name: GetGeneration()
+// Desc: Returns how many times the catalog has been loaded
+// Preconditions: None
+// Postconditions: Returns m_generation (1 for the first load)
+unsigned long Catalog::GetGeneration()
+{
+  return m_generation;
+}
+
+// Name: GetReport()
+// Desc: Returns the diff and build time of this snapshot
+// Preconditions: Load was called
+// Postconditions: Returns m_report
+ReloadReport Catalog::GetReport()
+{
+  return m_report;
+}
+
+// Name: ParseAirport(string)
+// Desc: Parses one line of the airport file (code,name,city,country,north,west)
+// Preconditions: None
+// Postconditions: Returns the airport. Throws invalid_argument or
+//   out_of_range (from stod) if the line is malformed
+Airport ParseAirport(const string &line)
+{
+  // Parse the line to extract airport details using ',' as the delimiter.
+  size_t pos = 0;                            // position in string to start searching for the next comma
+  size_t end = line.find(',', pos);          // find the first comma in the line
+  string code = line.substr(pos, end - pos); // extract airport code
+
+  pos = end + 1;
+  end = line.find(',', pos);
+  string name = line.substr(pos, end - pos);
+
+  pos = end + 1;
+  end = line.find(',', pos);
+  string city = line.substr(pos, end - pos);
+
+  pos = end + 1;
+  end = line.find(',', pos);
+  string country = line.substr(pos, end - pos);
+
+  pos = end + 1;
+  end = line.find(',', pos);
+  double north = stod(line.substr(pos, end - pos)); // Direct conversion, handles negative
+
+  pos = end + 1;
+  double west = stod(line.substr(pos)); // rest of the string, handles negative
+
+  return Airport(code, name, city, country, north, west);
+}
+
+// Name: AddMemory(MemoryReport&)
+// Desc: Counts the heap held by the snapshot. Airports, line hashes and the
+//   code and id tables go to m_catalog, the search index and grid (once
+//   built) to m_indexes and the search index's ranked lists to m_caches
+// Preconditions: None
+// Postconditions: report includes the snapshot
+void Catalog::AddMemory(MemoryReport &report)
+{
+  AddVector(report.m_catalog, m_airports);
+  for (size_t i = 0; i < m_airports.size(); i++)
+  {
+    AddBlock(report.m_catalog, sizeof(Airport));
+    m_airports[i]->AddMemory(report.m_catalog);
+  }
+  AddVector(report.m_catalog, m_lineHashes);
+  AddHashMap(report.m_catalog, m_codeIndex);
+  for (auto entry = m_codeIndex.begin(); entry != m_codeIndex.end(); ++entry)
+  {
+    AddString(report.m_catalog, entry->first);
+  }
+  AddHashMap(report.m_catalog, m_idIndex);
+  AddHashMap(report.m_catalog, m_ids);
+  for (auto entry = m_ids.begin(); entry != m_ids.end(); ++entry)
+  {
+    AddString(report.m_catalog, entry->first);
+  }
+
+  if (m_searchMillis >= 0.0) // an index still being built is not counted yet
+  {
+    m_search.AddMemory(report.m_indexes, report.m_caches);
+  }
+  if (m_gridMillis >= 0.0)
+  {
+    AddVector(report.m_indexes, m_grid);
+    for (size_t i = 0; i < m_grid.size(); i++)
+    {
+      AddVector(report.m_indexes, m_grid[i]);
+    }
+  }
+}
@@ -0,0 +1,182 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "Airport.h"
+#include "SearchIndex.h"
+#include "FeedStream.h"
+
+#include <fstream>
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+using namespace std;
+
+const int GRID_ROWS = 180; // One degree cells for the spatial grid
+const int GRID_COLUMNS = 360;
+
+// Summary of how a catalog snapshot differs from the one it replaced
+struct ReloadReport {
+  int m_added;     //Airports whose code is new in this snapshot
+  int m_removed;   //Airports whose code is gone from this snapshot
+  int m_changed;   //Airports whose line was edited (re-parsed)
+  int m_unchanged; //Airports copied over without parsing
+  double m_millis; //Time taken to read the snapshot (not its search index or grid)
+};
+
+// Name: ParseAirport(string)
+// Desc: Parses one line of the airport file (code,name,city,country,north,west)
+// Preconditions: None
+// Postconditions: Returns the airport. Throws invalid_argument or
+//   out_of_range (from stod) if the line is malformed
+Airport ParseAirport(const string &line);
+
+class Catalog {
+ public:
+  // Name: Catalog() - Default Constructor
+  // Desc: Builds a new empty catalog snapshot
+  // Preconditions: None
+  // Postconditions: Creates an empty catalog with generation 0
+  Catalog();
+  // Name: ~Catalog() - Destructor
+  // Desc: Deallocates every airport owned by the snapshot
+  // Preconditions: No reader still holds this snapshot
+  // Postconditions: All airports are deleted
+  ~Catalog();
+  // Name: Load(string, Catalog*)
+  // Desc: Reads a file of airports (code,name,city,country,north,west).
+  //   If a previous snapshot is given, lines that are identical to the
+  //   previous snapshot (same hash, then the same fields as its airport)
+  //   are copied instead of interned again, and every code
+  //   keeps the id it had before. New codes get fresh ids.
+  //   Reading stops at the first empty line. Only the code and id tables
+  //   are built here; the search index and grid are built by
+  //   BuildIndexes or by the first Search or InBox, so the snapshot can
+  //   be published sooner
+  // Preconditions: previous is either nullptr or a fully built snapshot
+  // Postconditions: Returns false if the file could not be opened.
+  //   Otherwise the snapshot is populated and m_report describes the diff
+  bool Load(string fileName, Catalog *previous);
+  // Name: Load(istream&, Catalog*)
+  // Desc: Load from lines that are already open (a shard's share of the
+  //   file, for example). Works the same as Load(string, Catalog*)
+  // Preconditions: previous is either nullptr or a fully built snapshot
+  // Postconditions: The snapshot is populated, returns true
+  bool Load(istream &input, Catalog *previous);
+  // Name: Load(FeedStream&, function)
+  // Desc: Loads the airports of a feed that keep accepts, a window at a
+  //   time, building each Airport from its parsed FeedAirport. Only
+  //   the kept airports are ever held, not the feed's text (a shard
+  //   worker loading its band, for example)
+  // Preconditions: The catalog is empty
+  // Postconditions: The snapshot is populated, returns true
+  bool Load(FeedStream &stream, const function<bool(const FeedAirport &)> &keep);
+  // Name: GetSize()
+  // Desc: Returns the number of airports in the snapshot
+  // Preconditions: None
+  // Postconditions: Returns m_airports.size()
+  int GetSize();
+  // Name: GetAirport(int)
+  // Desc: Returns the airport at a position in the snapshot
+  // Preconditions: None
+  // Postconditions: Returns the airport or nullptr if out of range
+  Airport* GetAirport(int index);
+  // Name: FindCode(string)
+  // Desc: Looks up an airport by its three letter code
+  // Preconditions: None
+  // Postconditions: Returns the index of the airport or -1
+  int FindCode(string code);
+  // Name: FindId(int)
+  // Desc: Looks up an airport by its stable id
+  // Preconditions: None
+  // Postconditions: Returns the airport or nullptr if the id is not
+  //   in this snapshot (for example it was removed by a reload)
+  Airport* FindId(int id);
+  // Name: BuildIndexes()
+  // Desc: Builds the search index and then the grid unless they are
+  //   built already, for a background thread to call right after Load.
+  //   A Search or InBox that comes first builds its own index, and one
+  //   that comes while its index is being built waits for it
+  // Preconditions: Load was called
+  // Postconditions: Both indexes are built
+  void BuildIndexes();
+  // Name: GetSearchMillis() / GetGridMillis()
+  // Desc: Return how long the search index and the grid took to build
+  // Preconditions: None
+  // Postconditions: Returns the milliseconds, or -1 if not built yet
+  double GetSearchMillis();
+  double GetGridMillis();
+  // Name: Search(string, int)
+  // Desc: Ranked prefix and typo tolerant search over the code, name,
+  //   city and country of every airport in the snapshot
+  // Preconditions: Load was called
+  // Postconditions: Returns at most limit matches, best first. Each
+  //   m_index is a position usable with GetAirport
+  vector<SearchMatch> Search(string query, int limit);
+  // Name: InBox(double, double, double, double)
+  // Desc: Returns every airport within northSpan degrees of north and
+  //   westSpan degrees of west, wrapping across the 180th meridian.
+  //   Only the grid cells that overlap the box are visited
+  // Preconditions: Load was called
+  // Postconditions: Returns airport indexes (candidates for an exact
+  //   distance check by the caller)
+  vector<int> InBox(double north, double west, double northSpan, double westSpan);
+  // Name: GetGeneration()
+  // Desc: Returns how many times the catalog has been loaded
+  // Preconditions: None
+  // Postconditions: Returns m_generation (1 for the first load)
+  unsigned long GetGeneration();
+  // Name: GetReport()
+  // Desc: Returns the diff and build time of this snapshot
+  // Preconditions: Load was called
+  // Postconditions: Returns m_report
+  ReloadReport GetReport();
+  // Name: AddMemory(MemoryReport&)
+  // Desc: Counts the heap held by the snapshot. Airports, line hashes and the
+  //   code and id tables go to m_catalog, the search index and grid to
+  //   m_indexes and the search index's ranked lists to m_caches
+  // Preconditions: None
+  // Postconditions: report includes the snapshot
+  void AddMemory(MemoryReport &report);
+ private:
+  // Name: BuildSearch() / BuildGrid()
+  // Desc: Build one index and record its time. Called once each,
+  //   through m_searchOnce and m_gridOnce
+  // Preconditions: Load was called
+  // Postconditions: The index is built, its millis are set last
+  void BuildSearch();
+  void BuildGrid();
+  // Name: Unchanged(string&, int)
+  // Desc: Tells whether a line with the same hash as the airport at
+  //   oldIndex holds the same fields (a 64 bit hash alone could collide)
+  // Preconditions: oldIndex is a position in this snapshot
+  // Postconditions: Returns true if the airport can be reused for line
+  bool Unchanged(const string &line, int oldIndex);
+  // Name: AddAirport(string&, uint64_t, Airport*)
+  // Desc: Appends a parsed airport, giving its code an id (the same one
+  //   as before if the code was ever seen)
+  // Preconditions: code is not in m_codeIndex yet
+  // Postconditions: The snapshot owns airport
+  void AddAirport(const string &code, uint64_t lineHash, Airport *airport);
+
+  vector<Airport *> m_airports; //Airports in file order
+  vector<uint64_t> m_lineHashes; //Hash of each airport's line, used to skip unchanged lines
+  unordered_map<string, int> m_codeIndex; //Code to index in m_airports
+  unordered_map<int, int> m_idIndex; //Id to index in m_airports
+  unordered_map<string, int> m_ids; //Every code ever seen to its id (ids are never reused)
+  int m_nextId; //Next id handed to a new code
+  unsigned long m_generation; //Load count
+  ReloadReport m_report; //Diff against the previous snapshot
+  SearchIndex m_search; //Name and city search over this snapshot (built once, on demand)
+  vector<vector<int> > m_grid; //Airport indexes per one degree cell, row major (built once, on demand)
+  once_flag m_searchOnce; //Guards building m_search
+  once_flag m_gridOnce; //Guards building m_grid
+  atomic<double> m_searchMillis; //Build time of m_search, -1 until it is built
+  atomic<double> m_gridMillis; //Build time of m_grid, -1 until it is built
+};
+
+#endif
@@ -0,0 +1,185 @@
+/*****************************************
+** File:    Centrality.cpp
+** Description: This file implements betweenness and closeness centrality over the leg graph to find hubs
+***********************************************/
+
+#include "Centrality.h"
+#include <algorithm>
+#include <queue>
+#include <thread>
+using namespace std;
+
+// Name: Centrality(LegGraph*, CentralityOptions)
+// Desc: Prepares a run over a leg graph (legs go both ways)
+// Preconditions: graph stays alive while Run runs
+// Postconditions: Scores are all zero
+Centrality::Centrality(LegGraph *graph, CentralityOptions options)
+    : m_graph(graph), m_options(options), m_nextSource(0),
+      m_betweenness(graph->GetSize(), 0.0), m_closeness(graph->GetSize(), 0.0)
+{
+  if (m_options.m_threads < 1)
+  {
+    m_options.m_threads = 1;
+  }
+}
+
+// Name: Run()
+// Desc: Brandes' algorithm weighted by miles, sources shared out over
+//   the threads
+// Preconditions: None
+// Postconditions: Betweenness holds every airport, closeness holds
+//   the airports that were sources (0 for the rest)
+void Centrality::Run()
+{
+  int size = m_graph->GetSize();
+  int samples = (m_options.m_samples <= 0 || m_options.m_samples > size) ? size : m_options.m_samples;
+  m_sources.clear();
+  for (int i = 0; i < samples; i++)
+  {
+    m_sources.push_back(static_cast<int>(static_cast<long long>(i) * size / samples)); // evenly spaced
+  }
+  m_nextSource = 0;
+
+  vector<vector<double> > partial(m_options.m_threads, vector<double>(size, 0.0));
+  vector<thread> workers;
+  for (int t = 1; t < m_options.m_threads; t++)
+  {
+    workers.push_back(thread(&Centrality::Work, this, ref(partial[t])));
+  }
+  Work(partial[0]); // this thread works too
+  for (size_t t = 0; t < workers.size(); t++)
+  {
+    workers[t].join();
+  }
+
+  // Every path is found from both of its ends, and a sample stands in
+  // for size / samples sources
+  double scale = 0.5 * size / samples;
+  for (int i = 0; i < size; i++)
+  {
+    double total = 0.0;
+    for (int t = 0; t < m_options.m_threads; t++)
+    {
+      total += partial[t][i];
+    }
+    m_betweenness[i] = total * scale;
+  }
+}
+
+// Name: Top(int, bool)
+// Desc: Returns the best hubs by betweenness or by closeness
+// Preconditions: Run was called
+// Postconditions: Returns at most count scores, best first
+vector<HubScore> Centrality::Top(int count, bool byBetweenness)
+{
+  vector<HubScore> scores(m_graph->GetSize());
+  for (size_t i = 0; i < scores.size(); i++)
+  {
+    scores[i].m_airport = i;
+    scores[i].m_betweenness = m_betweenness[i];
+    scores[i].m_closeness = m_closeness[i];
+  }
+  count = max(0, min(count, static_cast<int>(scores.size())));
+  partial_sort(scores.begin(), scores.begin() + count, scores.end(),
+               [byBetweenness](const HubScore &first, const HubScore &second) {
+                 double a = byBetweenness ? first.m_betweenness : first.m_closeness;
+                 double b = byBetweenness ? second.m_betweenness : second.m_closeness;
+                 return a != b ? a > b : first.m_airport < second.m_airport;
+               });
+  scores.resize(count);
+  return scores;
+}
+
+// Name: Work(vector<double>&)
+// Desc: Body of one thread. Takes sources until none are left
+// Preconditions: betweenness has one entry per airport
+// Postconditions: betweenness holds this thread's dependencies,
+//   m_closeness holds its sources' closeness
+void Centrality::Work(vector<double> &betweenness)
+{
+  int size = m_graph->GetSize();
+  vector<double> miles(size, -1.0); // -1 until reached
+  vector<double> paths(size, 0.0);  // shortest paths from the source
+  vector<double> depends(size, 0.0);
+  vector<int> order; // airports in the order they were settled
+  order.reserve(size);
+  typedef pair<double, int> Entry;
+
+  for (size_t next = m_nextSource++; next < m_sources.size(); next = m_nextSource++)
+  {
+    int source = m_sources[next];
+
+    // Dijkstra, counting the shortest paths into every airport
+    priority_queue<Entry, vector<Entry>, greater<Entry> > open;
+    miles[source] = 0.0;
+    paths[source] = 1.0;
+    open.push(Entry(0.0, source));
+    while (!open.empty())
+    {
+      Entry top = open.top();
+      open.pop();
+      int at = top.second;
+      if (top.first > miles[at])
+      {
+        continue; // already settled closer
+      }
+      order.push_back(at);
+      for (const Leg *leg = m_graph->Begin(at); leg != m_graph->End(at); ++leg)
+      {
+        double through = miles[at] + leg->m_miles;
+        if (miles[leg->m_to] < 0.0 || through < miles[leg->m_to])
+        {
+          miles[leg->m_to] = through;
+          paths[leg->m_to] = paths[at];
+          open.push(Entry(through, leg->m_to));
+        }
+        else if (through == miles[leg->m_to])
+        {
+          paths[leg->m_to] += paths[at]; // another shortest path
+        }
+      }
+    }
+
+    // Closeness (Wasserman and Faust, so islands of the graph compare
+    // fairly): reached share of the graph over the mean miles to it
+    double total = 0.0;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+      total += miles[order[i]];
+    }
+    int reached = order.size() - 1;
+    if (reached > 0 && total > 0.0)
+    {
+      m_closeness[source] = (static_cast<double>(reached) / (size - 1)) * (reached / total);
+    }
+
+    // Push dependencies back from the farthest airport. A leg is on a
+    // shortest path when it adds up exactly, which it does because the
+    // same sum set miles in the search above
+    for (size_t i = order.size(); i-- > 0;)
+    {
+      int at = order[i];
+      for (const Leg *leg = m_graph->Begin(at); leg != m_graph->End(at); ++leg)
+      {
+        int before = leg->m_to;
+        if (miles[before] >= 0.0 && miles[before] + leg->m_miles == miles[at])
+        {
+          depends[before] += paths[before] / paths[at] * (1.0 + depends[at]);
+        }
+      }
+      if (at != source)
+      {
+        betweenness[at] += depends[at];
+      }
+    }
+
+    // Reset only what this source touched
+    for (size_t i = 0; i < order.size(); i++)
+    {
+      miles[order[i]] = -1.0;
+      paths[order[i]] = 0.0;
+      depends[order[i]] = 0.0;
+    }
+    order.clear();
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef CENTRALITY_H
+#define CENTRALITY_H
+
+#include "LegGraph.h"
+
+#include <vector>
+#include <atomic>
+using namespace std;
+
+const int HUB_LIMIT = 10; // Hubs listed when a count is not given
+
+// How a centrality run is spread and sampled
+struct CentralityOptions {
+  int m_threads;  //Worker threads, each takes sources as it finishes the last
+  int m_samples;  //Sources to start from (0 or more than the graph means every airport)
+};
+
+// Scores of one airport
+struct HubScore {
+  int m_airport;        //Catalog index
+  double m_betweenness; //Share of shortest paths (by miles) that pass through the airport
+  double m_closeness;   //How near the airport is to everything it can reach
+};
+
+class Centrality {
+ public:
+  // Name: Centrality(LegGraph*, CentralityOptions)
+  // Desc: Prepares a run over a leg graph (legs go both ways)
+  // Preconditions: graph stays alive while Run runs
+  // Postconditions: Scores are all zero
+  Centrality(LegGraph *graph, CentralityOptions options);
+  // Name: Run()
+  // Desc: Brandes' algorithm weighted by miles: one Dijkstra search per
+  //   source, then the dependencies are pushed back along the shortest
+  //   path order. Sources are handed to the threads one at a time and
+  //   every thread adds into its own totals, merged at the end.
+  //   With sampling, sources are spread evenly over the catalog and
+  //   betweenness is scaled up to estimate the full count
+  // Preconditions: None
+  // Postconditions: Betweenness holds every airport, closeness holds
+  //   the airports that were sources (0 for the rest)
+  void Run();
+  // Name: Top(int, bool)
+  // Desc: Returns the best hubs by betweenness or by closeness
+  // Preconditions: Run was called
+  // Postconditions: Returns at most count scores, best first
+  vector<HubScore> Top(int count, bool byBetweenness);
+ private:
+  // Name: Work(vector<double>&)
+  // Desc: Body of one thread. Takes sources until none are left
+  // Preconditions: betweenness has one entry per airport
+  // Postconditions: betweenness holds this thread's dependencies,
+  //   m_closeness holds its sources' closeness
+  void Work(vector<double> &betweenness);
+
+  LegGraph *m_graph; //Graph being scored
+  CentralityOptions m_options; //Threads and sampling
+  vector<int> m_sources; //Airports searched from
+  atomic<size_t> m_nextSource; //Next entry of m_sources to hand out
+  vector<double> m_betweenness; //Score of every airport
+  vector<double> m_closeness; //Score of every source
+};
+
+#endif
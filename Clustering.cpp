@@ -0,0 +1,401 @@
+/*****************************************
+** File:    Clustering.cpp
+** Description: This file implements parallel k-means and density clustering of airports on the sphere
+***********************************************/
+
+#include "Clustering.h"
+#include "DistanceModel.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <cmath>
+using namespace std;
+
+const int SEED_BLOCK = 4096;  // Points per partial sum while seeding (fixed, so seeding repeats on any thread count)
+const int ASSIGN_BLOCK = 256; // Points assigned against every centre at once
+
+// Name: Clustering(vector<double>&, vector<double>&, ClusterOptions)
+// Desc: Prepares to cluster points given in degrees, kept as unit vectors
+// Preconditions: north and west have the same size
+// Postconditions: Ready to run
+Clustering::Clustering(const vector<double> &north, const vector<double> &west, ClusterOptions options)
+    : m_x(north.size()), m_y(north.size()), m_z(north.size()), m_options(options)
+{
+  if (m_options.m_threads < 1)
+  {
+    m_options.m_threads = 1;
+  }
+  for (size_t i = 0; i < north.size(); i++)
+  {
+    double latitude = north[i] * DEG_2_RAD;
+    double longitude = west[i] * DEG_2_RAD;
+    m_x[i] = cos(latitude) * cos(longitude);
+    m_y[i] = cos(latitude) * sin(longitude);
+    m_z[i] = sin(latitude);
+  }
+}
+
+// Name: KMeans(int)
+// Desc: Spherical k-means with k-means++ seeding, points assigned in
+//   blocks against all centres at once
+// Preconditions: k >= 1
+// Postconditions: Returns min(k, points) clusters. A centre that
+//   loses every point keeps its place
+Clusters Clustering::KMeans(int k)
+{
+  int size = m_x.size();
+  k = max(0, min(k, size));
+  Clusters clusters;
+  clusters.m_assignment.assign(size, 0);
+  clusters.m_iterations = 0;
+  vector<double> cx(k), cy(k), cz(k);
+  if (k == 0)
+  {
+    return clusters;
+  }
+
+  // Seeding: the first centre at random, each next one with odds by the
+  // squared chord to the nearest centre so far (2 - 2 dot)
+  mt19937 random(m_options.m_seed);
+  vector<double> nearest(size);
+  int blocks = (size + SEED_BLOCK - 1) / SEED_BLOCK;
+  vector<double> blockSums(blocks);
+  int pick = uniform_int_distribution<int>(0, size - 1)(random);
+  for (int c = 0; c < k; c++)
+  {
+    cx[c] = m_x[pick];
+    cy[c] = m_y[pick];
+    cz[c] = m_z[pick];
+    if (c + 1 == k)
+    {
+      break;
+    }
+    ParallelFor(blocks, [&](int begin, int end, int) {
+      for (int b = begin; b < end; b++)
+      {
+        double sum = 0.0;
+        for (int i = b * SEED_BLOCK; i < min(size, (b + 1) * SEED_BLOCK); i++)
+        {
+          double chord = max(0.0, 2.0 - 2.0 * (m_x[i] * cx[c] + m_y[i] * cy[c] + m_z[i] * cz[c]));
+          nearest[i] = (c == 0) ? chord : min(nearest[i], chord);
+          sum += nearest[i];
+        }
+        blockSums[b] = sum;
+      }
+    });
+    double total = 0.0;
+    for (int b = 0; b < blocks; b++)
+    {
+      total += blockSums[b];
+    }
+    if (total <= 0.0)
+    {
+      pick = uniform_int_distribution<int>(0, size - 1)(random); // every point sits on a centre
+      continue;
+    }
+    double target = uniform_real_distribution<double>(0.0, total)(random);
+    int b = 0;
+    while (b + 1 < blocks && target >= blockSums[b])
+    {
+      target -= blockSums[b++];
+    }
+    pick = min(size, (b + 1) * SEED_BLOCK) - 1; // rounding may run past the last point
+    for (int i = b * SEED_BLOCK; i < min(size, (b + 1) * SEED_BLOCK); i++)
+    {
+      if (target < nearest[i])
+      {
+        pick = i;
+        break;
+      }
+      target -= nearest[i];
+    }
+  }
+
+  // Rounds: assign, then move every centre to its points' mean
+  vector<vector<double> > sums(m_options.m_threads, vector<double>(4 * k));
+  clusters.m_sizes.assign(k, 0);
+  for (int round = 0; round < max(1, m_options.m_maxIterations); round++)
+  {
+    atomic<long> moved(0);
+    ParallelFor(size, [&](int begin, int end, int t) {
+      vector<double> &sum = sums[t];
+      fill(sum.begin(), sum.end(), 0.0);
+      double best[ASSIGN_BLOCK];
+      int label[ASSIGN_BLOCK];
+      long changes = 0;
+      for (int first = begin; first < end; first += ASSIGN_BLOCK)
+      {
+        int count = min(ASSIGN_BLOCK, end - first);
+        const double *x = &m_x[first];
+        const double *y = &m_y[first];
+        const double *z = &m_z[first];
+        for (int i = 0; i < count; i++)
+        {
+          best[i] = -2.0;
+          label[i] = 0;
+        }
+        for (int c = 0; c < k; c++)
+        {
+          double ax = cx[c], ay = cy[c], az = cz[c];
+          for (int i = 0; i < count; i++) // contiguous, so the compiler can vectorize it
+          {
+            double dot = x[i] * ax + y[i] * ay + z[i] * az;
+            bool closer = dot > best[i];
+            best[i] = closer ? dot : best[i];
+            label[i] = closer ? c : label[i];
+          }
+        }
+        for (int i = 0; i < count; i++)
+        {
+          int c = label[i];
+          if (clusters.m_assignment[first + i] != c)
+          {
+            clusters.m_assignment[first + i] = c;
+            changes++;
+          }
+          sum[4 * c] += x[i];
+          sum[4 * c + 1] += y[i];
+          sum[4 * c + 2] += z[i];
+          sum[4 * c + 3] += 1.0;
+        }
+      }
+      moved += changes;
+    });
+    clusters.m_iterations++;
+
+    for (int c = 0; c < k; c++)
+    {
+      double sx = 0.0, sy = 0.0, sz = 0.0, count = 0.0;
+      for (int t = 0; t < m_options.m_threads; t++)
+      {
+        sx += sums[t][4 * c];
+        sy += sums[t][4 * c + 1];
+        sz += sums[t][4 * c + 2];
+        count += sums[t][4 * c + 3];
+      }
+      clusters.m_sizes[c] = count;
+      double length = sqrt(sx * sx + sy * sy + sz * sz);
+      if (count > 0.0 && length > 0.0)
+      {
+        cx[c] = sx / length;
+        cy[c] = sy / length;
+        cz[c] = sz / length;
+      }
+    }
+    if (moved == 0 && round > 0)
+    {
+      break; // nothing moved, so the centres did not either
+    }
+  }
+
+  for (int c = 0; c < k; c++)
+  {
+    clusters.m_north.push_back(asin(max(-1.0, min(1.0, cz[c]))) * RAD_2_DEG);
+    clusters.m_west.push_back(atan2(cy[c], cx[c]) * RAD_2_DEG);
+  }
+  return clusters;
+}
+
+// Name: Density(int, function)
+// Desc: DBSCAN with core points found and joined in parallel, each
+//   point's neighbours looked up once
+// Preconditions: near is safe to call from several threads at once
+// Postconditions: Returns clusters numbered by their first point
+Clusters Clustering::Density(int minPoints, function<void(int, vector<int> &)> near)
+{
+  int size = m_x.size();
+  Clusters clusters;
+  clusters.m_assignment.assign(size, CLUSTER_NOISE);
+  clusters.m_iterations = 0;
+
+  // Core points. near runs once per point: every thread keeps the lists
+  // it found one after another, for the join and the border points
+  vector<char> core(size, 0);
+  vector<vector<int> > lists(m_options.m_threads);
+  vector<int> owner(size);     // thread whose lists hold the point's
+  vector<size_t> offset(size); // where they start there
+  vector<int> counts(size);
+  ParallelFor(size, [&](int begin, int end, int t) {
+    vector<int> found;
+    for (int i = begin; i < end; i++)
+    {
+      found.clear();
+      near(i, found);
+      owner[i] = t;
+      offset[i] = lists[t].size();
+      counts[i] = found.size();
+      lists[t].insert(lists[t].end(), found.begin(), found.end());
+      core[i] = counts[i] >= minPoints;
+    }
+  });
+  auto neighbours = [&](int i) { return lists[owner[i]].data() + offset[i]; };
+
+  // Join core neighbours. A root only ever links to a smaller root, with
+  // compare and swap, so threads can join at the same time
+  unique_ptr<atomic<int>[]> parent(new atomic<int>[size]);
+  for (int i = 0; i < size; i++)
+  {
+    parent[i] = i;
+  }
+  // Path halving: every point passed is pointed at its grandparent. That
+  // is still one of its roots' points (links only go to smaller roots,
+  // never undone), and a failed exchange only means another thread
+  // moved it up first
+  auto root = [&parent](int i) {
+    int up = parent[i];
+    while (up != i)
+    {
+      int above = parent[up];
+      if (above != up)
+      {
+        parent[i].compare_exchange_weak(up, above);
+      }
+      i = above;
+      up = parent[i];
+    }
+    return i;
+  };
+  ParallelFor(size, [&](int begin, int end, int) {
+    for (int i = begin; i < end; i++)
+    {
+      if (!core[i])
+      {
+        continue;
+      }
+      const int *found = neighbours(i);
+      for (int j = 0; j < counts[i]; j++)
+      {
+        if (found[j] <= i || !core[found[j]])
+        {
+          continue;
+        }
+        while (true)
+        {
+          int first = root(i);
+          int second = root(found[j]);
+          if (first == second)
+          {
+            break;
+          }
+          if (first > second)
+          {
+            swap(first, second);
+          }
+          if (parent[second].compare_exchange_strong(second, first))
+          {
+            break;
+          }
+        }
+      }
+    }
+  });
+
+  // Number the clusters by their first point
+  vector<int> clusterOf(size, -1);
+  int count = 0;
+  for (int i = 0; i < size; i++)
+  {
+    if (core[i])
+    {
+      int top = root(i);
+      if (clusterOf[top] < 0)
+      {
+        clusterOf[top] = count++;
+      }
+      clusters.m_assignment[i] = clusterOf[top];
+    }
+  }
+
+  // Border points join their first core neighbour
+  ParallelFor(size, [&](int begin, int end, int) {
+    for (int i = begin; i < end; i++)
+    {
+      if (core[i])
+      {
+        continue;
+      }
+      const int *found = neighbours(i);
+      int first = size;
+      for (int j = 0; j < counts[i]; j++)
+      {
+        if (core[found[j]])
+        {
+          first = min(first, found[j]);
+        }
+      }
+      if (first < size)
+      {
+        clusters.m_assignment[i] = clusters.m_assignment[first];
+      }
+    }
+  });
+
+  Centroids(clusters, count);
+  return clusters;
+}
+
+// Name: Centroids(Clusters&, int)
+// Desc: Sets the centroid and size of every cluster from the assignment
+// Preconditions: assignment is filled, count clusters
+// Postconditions: m_north, m_west and m_sizes hold count entries
+void Clustering::Centroids(Clusters &clusters, int count)
+{
+  vector<vector<double> > sums(m_options.m_threads, vector<double>(4 * count, 0.0));
+  ParallelFor(m_x.size(), [&](int begin, int end, int t) {
+    for (int i = begin; i < end; i++)
+    {
+      int c = clusters.m_assignment[i];
+      if (c >= 0)
+      {
+        sums[t][4 * c] += m_x[i];
+        sums[t][4 * c + 1] += m_y[i];
+        sums[t][4 * c + 2] += m_z[i];
+        sums[t][4 * c + 3] += 1.0;
+      }
+    }
+  });
+  clusters.m_north.assign(count, 0.0);
+  clusters.m_west.assign(count, 0.0);
+  clusters.m_sizes.assign(count, 0);
+  for (int c = 0; c < count; c++)
+  {
+    double sx = 0.0, sy = 0.0, sz = 0.0, size = 0.0;
+    for (int t = 0; t < m_options.m_threads; t++)
+    {
+      sx += sums[t][4 * c];
+      sy += sums[t][4 * c + 1];
+      sz += sums[t][4 * c + 2];
+      size += sums[t][4 * c + 3];
+    }
+    double length = sqrt(sx * sx + sy * sy + sz * sz);
+    clusters.m_sizes[c] = size;
+    if (length > 0.0)
+    {
+      clusters.m_north[c] = asin(max(-1.0, min(1.0, sz / length))) * RAD_2_DEG;
+      clusters.m_west[c] = atan2(sy, sx) * RAD_2_DEG;
+    }
+  }
+}
+
+// Name: ParallelFor(int, function)
+// Desc: Runs work(begin, end, thread) over [0, count) split in one
+//   range per thread
+// Preconditions: None
+// Postconditions: Returns after every range is done
+void Clustering::ParallelFor(int count, function<void(int, int, int)> work)
+{
+  int threads = m_options.m_threads;
+  vector<thread> workers;
+  for (int t = 1; t < threads; t++)
+  {
+    workers.push_back(thread(work, static_cast<int>(static_cast<long long>(count) * t / threads),
+                             static_cast<int>(static_cast<long long>(count) * (t + 1) / threads), t));
+  }
+  work(0, static_cast<int>(static_cast<long long>(count) / threads), 0); // this thread takes the first range
+  for (size_t t = 0; t < workers.size(); t++)
+  {
+    workers[t].join();
+  }
+}
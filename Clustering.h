@@ -0,0 +1,77 @@
+#ifndef CLUSTERING_H
+#define CLUSTERING_H
+
+#include <vector>
+#include <functional>
+using namespace std;
+
+const int CLUSTER_NOISE = -1;      // Assignment of a point in no cluster (density clustering)
+const int CLUSTER_ITERATIONS = 50; // Most k-means rounds when not told otherwise
+
+// How a clustering run is spread and repeated
+struct ClusterOptions {
+  int m_threads;       //Worker threads for every pass over the points
+  int m_maxIterations; //Most k-means rounds (stops sooner once nothing moves)
+  unsigned m_seed;     //Seed of the k-means++ choices, so runs repeat
+};
+
+// Result of a clustering run
+struct Clusters {
+  vector<int> m_assignment; //Cluster of every point (CLUSTER_NOISE for none)
+  vector<double> m_north;   //Centroid of every cluster (degrees)
+  vector<double> m_west;
+  vector<int> m_sizes;      //Points in every cluster
+  int m_iterations;         //k-means rounds run (0 for density clustering)
+};
+
+class Clustering {
+ public:
+  // Name: Clustering(vector<double>&, vector<double>&, ClusterOptions)
+  // Desc: Prepares to cluster points given in degrees. They are kept as
+  //   unit vectors in three arrays, so nearness is a dot product
+  // Preconditions: north and west have the same size
+  // Postconditions: Ready to run
+  Clustering(const vector<double> &north, const vector<double> &west, ClusterOptions options);
+  // Name: KMeans(int)
+  // Desc: Spherical k-means: k-means++ seeding (each new centre picked
+  //   with odds by squared distance to the nearest centre so far), then
+  //   rounds of assigning every point to the centre with the largest dot
+  //   product and moving each centre to its points' normalized mean.
+  //   Points are assigned in blocks against all centres at once, blocks
+  //   shared out over the threads
+  // Preconditions: k >= 1
+  // Postconditions: Returns min(k, points) clusters. A centre that
+  //   loses every point keeps its place
+  Clusters KMeans(int k);
+  // Name: Density(int, function)
+  // Desc: DBSCAN: a point with at least minPoints neighbours (itself
+  //   included) is a core point, neighbouring core points share a
+  //   cluster, and other points join the cluster of their first core
+  //   neighbour or are noise. near(i, found) adds the points within the
+  //   radius of point i to found, which comes in empty.
+  //   Core points are found and joined in parallel (lock free union find
+  //   with path halving). near runs once per point, the lists are kept
+  //   for the join and the border points
+  // Preconditions: near is safe to call from several threads at once
+  // Postconditions: Returns clusters numbered by their first point
+  Clusters Density(int minPoints, function<void(int, vector<int> &)> near);
+ private:
+  // Name: Centroids(Clusters&, int)
+  // Desc: Sets the centroid and size of every cluster from the assignment
+  // Preconditions: assignment is filled, count clusters
+  // Postconditions: m_north, m_west and m_sizes hold count entries
+  void Centroids(Clusters &clusters, int count);
+  // Name: ParallelFor(int, function)
+  // Desc: Runs work(begin, end, thread) over [0, count) split in one
+  //   range per thread
+  // Preconditions: None
+  // Postconditions: Returns after every range is done
+  void ParallelFor(int count, function<void(int, int, int)> work);
+
+  vector<double> m_x; //Unit vector of every point
+  vector<double> m_y;
+  vector<double> m_z;
+  ClusterOptions m_options; //Threads, rounds and seed
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef COORD_H
+#define COORD_H
+
+#include <cmath>
+#include <cstdint>
+using namespace std;
+
+// Storage types for coordinates and stored distances. The default build
+// keeps doubles. Building with -DCOMPACT_COORDS halves them:
+//   Coord        degrees as 32 bit microdegrees (fixed point). Rounding
+//                moves a point by at most 0.5e-6 degrees (about 0.06 m),
+//                so a leg changes by at most 1e-4 miles. Source data
+//                with six or fewer decimals (the airport file has
+//                three) is stored exactly.
+//   StoredMiles  distances kept in tables (leg graph, caches) as floats.
+//                Relative error is at most 6e-8, under 0.001 miles for
+//                the longest possible leg (12,451 miles). Totals are
+//                still added up in double.
+// Every calculation still runs in double; only storage changes.
+#ifdef COMPACT_COORDS
+typedef int32_t Coord;
+typedef float StoredMiles;
+const double COORD_SCALE = 1000000.0; // microdegrees per degree
+#else
+typedef double Coord;
+typedef double StoredMiles;
+const double COORD_SCALE = 1.0;
+#endif
+
+// Name: ToCoord(double)
+// Desc: Converts degrees to the stored coordinate type
+// Preconditions: degrees is within [-360, 360]
+// Postconditions: Returns the stored value (rounded in compact builds)
+inline Coord ToCoord(double degrees)
+{
+#ifdef COMPACT_COORDS
+  return static_cast<Coord>(lround(degrees * COORD_SCALE));
+#else
+  return degrees;
+#endif
+}
+
+// Name: FromCoord(Coord)
+// Desc: Converts a stored coordinate back to degrees
+// Preconditions: None
+// Postconditions: Returns degrees
+inline double FromCoord(Coord stored)
+{
+  return stored / COORD_SCALE;
+}
+
+#endif
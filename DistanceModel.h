@@ -0,0 +1,167 @@
+#ifndef DISTANCEMODEL_H
+#define DISTANCEMODEL_H
+
+#include <cmath>
+using namespace std;
+
+// Constants used for calculating distance
+#define PI 3.14159265358979323846
+#define EARTH_RADIUS 3958.8 // in miles
+#define DEG_2_RAD PI / 180
+#define RAD_2_DEG 180 / PI
+
+// WGS-84 ellipsoid used by the Vincenty model
+const double WGS84_MAJOR = 3963.190592; // equatorial radius in miles
+const double WGS84_FLATTENING = 1 / 298.257223563;
+
+// Distance models. Each is a policy with static functions so code that
+// takes the model as a template parameter is compiled once per model
+// with no virtual calls. Every model takes degrees North and West like
+// CalcDistance and returns miles.
+//   Miles(n1, w1, n2, w2)   distance between two points
+//   ERROR                   largest relative difference from the
+//                           spherical (Haversine) distance wherever
+//                           Valid is true
+//   Valid(n1, n2, miles)    whether ERROR holds for a pair at these
+//                           latitudes that the model measured as miles
+
+// Flat earth approximation, fast enough to filter with. Measured within
+// 0.8% of Haversine for legs under 1000 miles below 60 degrees latitude
+struct Equirectangular {
+  static constexpr double ERROR = 0.01;
+  static double Miles(double north1, double west1, double north2, double west2)
+  {
+    double lng_diff = west1 - west2;
+    if (lng_diff > 180.0) // take the short way across the 180th meridian
+    {
+      lng_diff -= 360.0;
+    }
+    else if (lng_diff < -180.0)
+    {
+      lng_diff += 360.0;
+    }
+    double x = lng_diff * DEG_2_RAD * cos((north1 + north2) / 2 * DEG_2_RAD);
+    double y = (north1 - north2) * DEG_2_RAD;
+    return double(EARTH_RADIUS) * sqrt(x * x + y * y);
+  }
+  static bool Valid(double north1, double north2, double miles)
+  {
+    return miles <= 1000.0 && fabs(north1) <= 60.0 && fabs(north2) <= 60.0;
+  }
+};
+
+// Spherical great circle distance, the same formula as CalcDistance
+struct Haversine {
+  static constexpr double ERROR = 0.0;
+  static double Miles(double north1, double west1, double north2, double west2)
+  {
+    double lat_new = north2 * DEG_2_RAD;
+    double lat_old = north1 * DEG_2_RAD;
+    double lat_diff = (north1 - north2) * DEG_2_RAD;
+    double lng_diff = (west1 - west2) * DEG_2_RAD;
+
+    double a = sin(lat_diff / 2) * sin(lat_diff / 2) +
+               cos(lat_new) * cos(lat_old) *
+                   sin(lng_diff / 2) * sin(lng_diff / 2);
+    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
+
+    return double(EARTH_RADIUS) * c;
+  }
+  static bool Valid(double, double, double)
+  {
+    return true;
+  }
+};
+
+// Geodesic distance on the WGS-84 ellipsoid (Vincenty's inverse formula),
+// accurate to well under a mile for billing. The iteration does not
+// converge for nearly antipodal points; those fall back to Haversine
+struct Vincenty {
+  static constexpr double ERROR = 0.006; // the ellipsoid differs from the sphere by at most about 0.56%
+  static double Miles(double north1, double west1, double north2, double west2)
+  {
+    const double minor = WGS84_MAJOR * (1 - WGS84_FLATTENING);
+    double u1 = atan((1 - WGS84_FLATTENING) * tan(north1 * DEG_2_RAD));
+    double u2 = atan((1 - WGS84_FLATTENING) * tan(north2 * DEG_2_RAD));
+    double sinU1 = sin(u1), cosU1 = cos(u1);
+    double sinU2 = sin(u2), cosU2 = cos(u2);
+    double lng = (west2 - west1) * DEG_2_RAD;
+
+    double lambda = lng;
+    double sinSigma = 0.0, cosSigma = 0.0, sigma = 0.0;
+    double cosSqAlpha = 0.0, cos2SigmaM = 0.0;
+    for (int iteration = 0; iteration < 200; iteration++)
+    {
+      double sinLambda = sin(lambda), cosLambda = cos(lambda);
+      double crossed = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+      sinSigma = sqrt(cosU2 * sinLambda * cosU2 * sinLambda + crossed * crossed);
+      if (sinSigma == 0.0)
+      {
+        return 0.0; // same point
+      }
+      cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+      sigma = atan2(sinSigma, cosSigma);
+      double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+      cosSqAlpha = 1 - sinAlpha * sinAlpha;
+      cos2SigmaM = (cosSqAlpha != 0.0) ? cosSigma - 2 * sinU1 * sinU2 / cosSqAlpha : 0.0; // 0 on the equator
+      double c = WGS84_FLATTENING / 16 * cosSqAlpha * (4 + WGS84_FLATTENING * (4 - 3 * cosSqAlpha));
+      double previous = lambda;
+      lambda = lng + (1 - c) * WGS84_FLATTENING * sinAlpha *
+                         (sigma + c * sinSigma * (cos2SigmaM + c * cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM)));
+      if (fabs(lambda - previous) < 1e-12)
+      {
+        double uSq = cosSqAlpha * (WGS84_MAJOR * WGS84_MAJOR - minor * minor) / (minor * minor);
+        double bigA = 1 + uSq / 16384 * (4096 + uSq * (-768 + uSq * (320 - 175 * uSq)));
+        double bigB = uSq / 1024 * (256 + uSq * (-128 + uSq * (74 - 47 * uSq)));
+        double deltaSigma = bigB * sinSigma *
+                            (cos2SigmaM + bigB / 4 * (cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM) -
+                                                      bigB / 6 * cos2SigmaM * (-3 + 4 * sinSigma * sinSigma) *
+                                                          (-3 + 4 * cos2SigmaM * cos2SigmaM)));
+        return minor * bigA * (sigma - deltaSigma);
+      }
+    }
+    return Haversine::Miles(north1, west1, north2, west2); // nearly antipodal
+  }
+  static bool Valid(double, double, double)
+  {
+    return true;
+  }
+};
+
+// Two stage range test: the Approx model rejects or accepts pairs that are
+// clearly outside or inside the range, and only pairs close to the edge
+// (or outside the range where Approx is Valid) are measured with Exact.
+// The answers are exactly those Exact would give alone
+template <class Approx, class Exact>
+struct TwoStage {
+  static double Miles(double north1, double west1, double north2, double west2)
+  {
+    return Exact::Miles(north1, west1, north2, west2);
+  }
+  static bool Within(double north1, double west1, double north2, double west2, double miles)
+  {
+    double approx = Approx::Miles(north1, west1, north2, west2);
+    if (Approx::Valid(north1, north2, approx))
+    {
+      // Both models are within their ERROR of the sphere, so these bounds
+      // hold for the Exact distance too
+      if (approx * (1 - Exact::ERROR) > miles * (1 + Approx::ERROR))
+      {
+        return false;
+      }
+      if (approx * (1 + Exact::ERROR) < miles * (1 - Approx::ERROR))
+      {
+        return true;
+      }
+    }
+    return Exact::Miles(north1, west1, north2, west2) <= miles;
+  }
+};
+
+// Model used by RouteDistance, chosen when building (-DDISTANCE_MODEL=Vincenty)
+#ifndef DISTANCE_MODEL
+#define DISTANCE_MODEL Haversine
+#endif
+typedef DISTANCE_MODEL DefaultDistance;
+
+#endif
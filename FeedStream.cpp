@@ -0,0 +1,233 @@
+/*****************************************
+** File:    FeedStream.cpp
+** Description: This file implements bounded memory streaming of airport feeds too large to load as a catalog
+***********************************************/
+
+#include "FeedStream.h"
+#include "DistanceModel.h"
+using namespace std;
+
+// Name: ParseFeedAirport(string&, FeedAirport&)
+// Desc: Parses one line of the airport file (code,name,city,country,north,west)
+//   the way ParseAirport does, but into plain strings
+// Preconditions: None
+// Postconditions: airport holds the line. Throws invalid_argument or
+//   out_of_range (from stod) if the line is malformed
+void ParseFeedAirport(const string &line, FeedAirport &airport)
+{
+  string *fields[] = {&airport.m_code, &airport.m_name, &airport.m_city, &airport.m_country};
+  size_t pos = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    size_t end = line.find(',', pos);
+    fields[i]->assign(line, pos, end - pos);
+    pos = end + 1;
+  }
+  size_t end = line.find(',', pos);
+  airport.m_north = stod(line.substr(pos, end - pos));
+  airport.m_west = stod(line.substr(end + 1)); // rest of the string
+}
+
+// Name: FeedStream(istream&, size_t)
+// Desc: Prepares to read an airport feed (a file or standard input)
+//   a window of at most windowBytes bytes at a time
+// Preconditions: input stays open while the stream is used
+// Postconditions: Nothing is read yet
+FeedStream::FeedStream(istream &input, size_t windowBytes)
+    : m_input(input), m_buffer(windowBytes > 1 ? windowBytes : 2), m_bad(0), m_done(false)
+{
+}
+
+// Name: NextWindow()
+// Desc: Reads the next window of whole lines and parses them. A line
+//   cut off at the end of the window is carried into the next one.
+//   The window's buffers are reused, so memory stays at the window size
+//   (plus one line if a single line is longer than the window)
+// Preconditions: None
+// Postconditions: Returns false once the input is used up.
+//   GetAirports and GetLines describe the window
+bool FeedStream::NextWindow()
+{
+  m_airports.clear();
+  m_lines.clear();
+  if (m_done)
+  {
+    return false;
+  }
+
+  // The carried part of a line counts against the window
+  size_t room = m_buffer.size() - 1;
+  if (m_carry.size() < room)
+  {
+    room -= m_carry.size();
+  }
+  else
+  {
+    room = 1; // one huge line, keep reading it a little at a time
+  }
+  m_input.read(m_buffer.data(), room);
+  size_t got = m_input.gcount();
+  if (got < room)
+  {
+    m_done = true; // end of the feed
+  }
+
+  size_t start = 0;
+  for (size_t i = 0; i <= got; i++)
+  {
+    bool endOfLine = i < got && m_buffer[i] == '\n';
+    bool lastLine = i == got && m_done;
+    if (!endOfLine && !lastLine)
+    {
+      continue;
+    }
+    m_carry.append(m_buffer.data() + start, i - start);
+    start = i + 1;
+    if (!m_carry.empty() && m_carry.back() == '\r')
+    {
+      m_carry.pop_back();
+    }
+    if (!m_carry.empty()) // blank lines are skipped
+    {
+      try
+      {
+        FeedAirport airport;
+        ParseFeedAirport(m_carry, airport);
+        m_airports.push_back(airport);
+        m_lines.push_back(m_carry);
+      }
+      catch (const exception &)
+      {
+        m_bad++;
+      }
+    }
+    m_carry.clear();
+  }
+  if (start < got)
+  {
+    m_carry.append(m_buffer.data() + start, got - start); // finished by the next window
+  }
+  return true;
+}
+
+// Name: GetAirports()
+// Desc: Returns the airports parsed from the current window
+// Preconditions: NextWindow returned true
+// Postconditions: Valid until the next call to NextWindow
+vector<FeedAirport> &FeedStream::GetAirports()
+{
+  return m_airports;
+}
+
+// Name: GetLines()
+// Desc: Returns the raw line of each airport in GetAirports
+// Preconditions: NextWindow returned true
+// Postconditions: Valid until the next call to NextWindow
+vector<string> &FeedStream::GetLines()
+{
+  return m_lines;
+}
+
+// Name: GetBadLines()
+// Desc: Returns how many lines so far did not parse
+// Preconditions: None
+// Postconditions: Returns m_bad
+long FeedStream::GetBadLines()
+{
+  return m_bad;
+}
+
+// Name: GetWindowBytes()
+// Desc: Returns the memory held by the current window
+// Preconditions: None
+// Postconditions: Returns buffer, line and airport bytes (estimated
+//   from capacities, the parsed fields taking about what their line does)
+size_t FeedStream::GetWindowBytes()
+{
+  size_t bytes = m_buffer.capacity() + m_carry.capacity();
+  bytes += m_lines.capacity() * sizeof(string) + m_airports.capacity() * sizeof(FeedAirport);
+  for (size_t i = 0; i < m_lines.size(); i++)
+  {
+    // the line itself, and about as much again for its parsed fields
+    bytes += 2 * m_lines[i].capacity();
+  }
+  return bytes;
+}
+
+// Name: RunFeed(istream&, FeedOptions&)
+// Desc: Streams a feed through filter, extract and aggregate stages one
+//   window at a time. Airports are never kept past their window, so
+//   memory depends on the window size and not on the size of the feed
+// Preconditions: options.m_windowBytes is positive
+// Postconditions: Returns the totals; kept lines went to m_extract
+FeedTotals RunFeed(istream &input, FeedOptions &options)
+{
+  FeedTotals totals;
+  totals.m_read = 0;
+  totals.m_bad = 0;
+  totals.m_kept = 0;
+  totals.m_windows = 0;
+  totals.m_totalMiles = 0.0;
+  totals.m_nearestMiles = -1.0;
+  totals.m_farthestMiles = -1.0;
+  totals.m_peakBytes = 0;
+
+  FeedStream stream(input, options.m_windowBytes);
+  while (stream.NextWindow())
+  {
+    vector<FeedAirport> &airports = stream.GetAirports();
+    vector<string> &lines = stream.GetLines();
+    totals.m_windows++;
+    totals.m_read += airports.size();
+    if (stream.GetWindowBytes() > totals.m_peakBytes)
+    {
+      totals.m_peakBytes = stream.GetWindowBytes();
+    }
+
+    for (size_t i = 0; i < airports.size(); i++)
+    {
+      FeedAirport &airport = airports[i];
+
+      // Filter
+      if (!options.m_country.empty() && airport.m_country != options.m_country)
+      {
+        continue;
+      }
+      double miles = 0.0;
+      if (options.m_hasPoint)
+      {
+        miles = Haversine::Miles(options.m_north, options.m_west, airport.m_north, airport.m_west);
+        if (options.m_miles > 0.0 && miles > options.m_miles)
+        {
+          continue;
+        }
+      }
+
+      // Extract
+      totals.m_kept++;
+      if (options.m_extract != nullptr)
+      {
+        *options.m_extract << lines[i] << '\n';
+      }
+
+      // Aggregate
+      if (options.m_hasPoint)
+      {
+        totals.m_totalMiles += miles;
+        if (totals.m_nearestMiles < 0.0 || miles < totals.m_nearestMiles)
+        {
+          totals.m_nearestMiles = miles;
+          totals.m_nearestCode = airport.m_code;
+        }
+        if (miles > totals.m_farthestMiles)
+        {
+          totals.m_farthestMiles = miles;
+          totals.m_farthestCode = airport.m_code;
+        }
+      }
+    }
+  }
+  totals.m_bad = stream.GetBadLines();
+  totals.m_read += totals.m_bad;
+  return totals;
+}
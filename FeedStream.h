@@ -0,0 +1,112 @@
+#ifndef FEEDSTREAM_H
+#define FEEDSTREAM_H
+
+#include <string>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const size_t FEED_WINDOW_DEFAULT = 64 * 1024; // Bytes of input held at once
+
+// One airport line of a feed, parsed into plain fields. Nothing is
+// interned: the shared SymbolTable never shrinks, so a feed interned
+// there would stay resident long after its window is gone
+struct FeedAirport {
+  string m_code;
+  string m_name;
+  string m_city;
+  string m_country;
+  double m_north; //Degrees north
+  double m_west;  //Degrees west
+};
+
+// What a streaming run keeps and computes. Empty or false fields are off
+struct FeedOptions {
+  size_t m_windowBytes; //Bytes of input read per window
+  string m_country;     //Keep only airports in this country
+  bool m_hasPoint;      //Measure distances from m_north, m_west
+  double m_north;       //Point for the distance filter and totals
+  double m_west;
+  double m_miles;       //Keep only airports within this many miles of the point (0 keeps all)
+  ostream *m_extract;   //Kept lines are copied here (may be nullptr)
+};
+
+// Running totals of a streaming run
+struct FeedTotals {
+  long m_read;           //Lines read
+  long m_bad;            //Lines that did not parse
+  long m_kept;           //Airports that passed the filters
+  long m_windows;        //Windows processed
+  double m_totalMiles;   //Sum of miles from the point to every kept airport
+  double m_nearestMiles; //Closest kept airport to the point
+  string m_nearestCode;
+  double m_farthestMiles; //Farthest kept airport from the point
+  string m_farthestCode;
+  size_t m_peakBytes;    //Most memory held by the window at once
+};
+
+class FeedStream {
+ public:
+  // Name: FeedStream(istream&, size_t)
+  // Desc: Prepares to read an airport feed (a file or standard input)
+  //   a window of at most windowBytes bytes at a time
+  // Preconditions: input stays open while the stream is used
+  // Postconditions: Nothing is read yet
+  FeedStream(istream &input, size_t windowBytes);
+  // Name: NextWindow()
+  // Desc: Reads the next window of whole lines and parses them. A line
+  //   cut off at the end of the window is carried into the next one.
+  //   The window's buffers are reused, so memory stays at the window size
+  //   (plus one line if a single line is longer than the window)
+  // Preconditions: None
+  // Postconditions: Returns false once the input is used up.
+  //   GetAirports and GetLines describe the window
+  bool NextWindow();
+  // Name: GetAirports()
+  // Desc: Returns the airports parsed from the current window
+  // Preconditions: NextWindow returned true
+  // Postconditions: Valid until the next call to NextWindow
+  vector<FeedAirport>& GetAirports();
+  // Name: GetLines()
+  // Desc: Returns the raw line of each airport in GetAirports
+  // Preconditions: NextWindow returned true
+  // Postconditions: Valid until the next call to NextWindow
+  vector<string>& GetLines();
+  // Name: GetBadLines()
+  // Desc: Returns how many lines so far did not parse
+  // Preconditions: None
+  // Postconditions: Returns m_bad
+  long GetBadLines();
+  // Name: GetWindowBytes()
+  // Desc: Returns the memory held by the current window
+  // Preconditions: None
+  // Postconditions: Returns buffer, line and airport bytes (estimated
+  //   from capacities, the parsed fields taking about what their line does)
+  size_t GetWindowBytes();
+ private:
+  istream &m_input; //Feed being read
+  vector<char> m_buffer; //Raw bytes of the window
+  string m_carry; //Start of a line cut off by the last window
+  vector<FeedAirport> m_airports; //Parsed airports of the window
+  vector<string> m_lines; //Raw line of each parsed airport
+  long m_bad; //Lines that did not parse
+  bool m_done; //Input is used up
+};
+
+// Name: ParseFeedAirport(string&, FeedAirport&)
+// Desc: Parses one line of the airport file (code,name,city,country,north,west)
+//   the way ParseAirport does, but into plain strings
+// Preconditions: None
+// Postconditions: airport holds the line. Throws invalid_argument or
+//   out_of_range (from stod) if the line is malformed
+void ParseFeedAirport(const string &line, FeedAirport &airport);
+
+// Name: RunFeed(istream&, FeedOptions&)
+// Desc: Streams a feed through filter, extract and aggregate stages one
+//   window at a time. Airports are never kept past their window, so
+//   memory depends on the window size and not on the size of the feed
+// Preconditions: options.m_windowBytes is positive
+// Postconditions: Returns the totals; kept lines went to m_extract
+FeedTotals RunFeed(istream &input, FeedOptions &options);
+
+#endif
@@ -0,0 +1,79 @@
+/*****************************************
+** File:    LegGraph.cpp
+** Description: This file implements the compact graph of flyable legs between catalog airports
+***********************************************/
+
+#include "LegGraph.h"
+
+#include <stdexcept>
+using namespace std;
+
+// Name: LegGraph() - Default Constructor
+// Desc: Builds an empty graph
+// Preconditions: None
+// Postconditions: Graph has no airports
+LegGraph::LegGraph()
+{
+  m_offsets.push_back(0);
+}
+
+// Name: AddAirport(vector<Leg>&)
+// Desc: Appends the next airport (in catalog order) with its legs
+// Preconditions: Airports are added in catalog index order
+// Postconditions: The airport and its legs are stored. Throws
+//   length_error if the graph cannot hold that many legs
+void LegGraph::AddAirport(const vector<Leg> &legs)
+{
+  if (legs.size() > m_legs.max_size() - m_legs.size())
+  {
+    throw length_error("LegGraph: too many legs");
+  }
+  m_legs.insert(m_legs.end(), legs.begin(), legs.end());
+  m_offsets.push_back(m_legs.size());
+}
+
+// Name: GetSize()
+// Desc: Returns the number of airports in the graph
+// Preconditions: None
+// Postconditions: Returns the airport count
+int LegGraph::GetSize()
+{
+  return static_cast<int>(m_offsets.size()) - 1;
+}
+
+// Name: GetLegCount()
+// Desc: Returns the number of legs in the graph
+// Preconditions: None
+// Postconditions: Returns m_legs.size() (may be above INT_MAX)
+size_t LegGraph::GetLegCount()
+{
+  return m_legs.size();
+}
+
+// Name: Begin(int)
+// Desc: Returns the first leg leaving an airport
+// Preconditions: airport is in [0, GetSize())
+// Postconditions: Returns a pointer into m_legs
+const Leg *LegGraph::Begin(int airport)
+{
+  return m_legs.data() + m_offsets[airport];
+}
+
+// Name: End(int)
+// Desc: Returns one past the last leg leaving an airport
+// Preconditions: airport is in [0, GetSize())
+// Postconditions: Returns a pointer into m_legs
+const Leg *LegGraph::End(int airport)
+{
+  return m_legs.data() + m_offsets[airport + 1];
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the offset and leg arrays
+// Preconditions: None
+// Postconditions: usage includes the graph
+void LegGraph::AddMemory(MemoryUsage &usage)
+{
+  AddVector(usage, m_offsets);
+  AddVector(usage, m_legs);
+}
@@ -0,0 +1,56 @@
+#ifndef LEGGRAPH_H
+#define LEGGRAPH_H
+
+#include <vector>
+#include <cstddef>
+
+#include "Coord.h"
+#include "Memory.h"
+using namespace std;
+
+// One flyable leg out of an airport
+struct Leg {
+  int m_to;       //Catalog index of the airport at the end of the leg
+  StoredMiles m_miles; //Length of the leg (float in compact builds, see Coord.h)
+};
+
+class LegGraph {
+ public:
+  // Name: LegGraph() - Default Constructor
+  // Desc: Builds an empty graph
+  // Preconditions: None
+  // Postconditions: Graph has no airports
+  LegGraph();
+  // Name: AddAirport(vector<Leg>&)
+  // Desc: Appends the next airport (in catalog order) with its legs
+  // Preconditions: Airports are added in catalog index order
+  // Postconditions: The airport and its legs are stored. Throws
+  //   length_error if the graph cannot hold that many legs
+  void AddAirport(const vector<Leg> &legs);
+  // Name: GetSize()
+  // Desc: Returns the number of airports in the graph
+  // Preconditions: None
+  // Postconditions: Returns the airport count
+  int GetSize();
+  // Name: GetLegCount()
+  // Desc: Returns the number of legs in the graph
+  // Preconditions: None
+  // Postconditions: Returns m_legs.size() (may be above INT_MAX)
+  size_t GetLegCount();
+  // Name: Begin(int) / End(int)
+  // Desc: Return the range of legs leaving an airport
+  // Preconditions: airport is in [0, GetSize())
+  // Postconditions: Returns pointers into m_legs
+  const Leg* Begin(int airport);
+  const Leg* End(int airport);
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the offset and leg arrays
+  // Preconditions: None
+  // Postconditions: usage includes the graph
+  void AddMemory(MemoryUsage &usage);
+ private:
+  vector<size_t> m_offsets; //First leg of each airport, plus one past the end
+  vector<Leg> m_legs; //Legs of every airport, grouped by airport
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+// Bytes and heap blocks held by one subsystem. Bytes are what was asked
+// of the allocator (capacity, not size); allocator overhead per block is
+// not included, so allocations * 16 is a fair guess at what it adds
+struct MemoryUsage {
+  size_t m_bytes;      //Heap bytes held
+  long m_allocations;  //Heap blocks held
+};
+
+// Footprint of a Navigator split by subsystem
+struct MemoryReport {
+  MemoryUsage m_catalog;  //Airports, line hashes and the code and id tables
+  MemoryUsage m_routes;   //Stored routes and their airport nodes
+  MemoryUsage m_indexes;  //Search trie, trigram lists, grid and route index
+  MemoryUsage m_caches;   //Results kept only to answer queries faster
+};
+
+// Name: AddBlock(MemoryUsage&, size_t)
+// Desc: Counts one heap block of bytes (nothing for an empty block)
+// Preconditions: None
+// Postconditions: usage includes the block
+inline void AddBlock(MemoryUsage &usage, size_t bytes)
+{
+  if (bytes > 0)
+  {
+    usage.m_bytes += bytes;
+    usage.m_allocations++;
+  }
+}
+
+// Name: AddString(MemoryUsage&, string&)
+// Desc: Counts the heap buffer of a string. Short strings live inside
+//   the string object (small string optimization) and cost nothing here
+// Preconditions: None
+// Postconditions: usage includes the buffer, if any
+inline void AddString(MemoryUsage &usage, const string &text)
+{
+  static const size_t INLINE_CAPACITY = string().capacity();
+  if (text.capacity() > INLINE_CAPACITY)
+  {
+    AddBlock(usage, text.capacity() + 1);
+  }
+}
+
+// Name: AddVector(MemoryUsage&, vector<T>&)
+// Desc: Counts the buffer of a vector, slack included. Heap memory owned
+//   by the elements is left to the caller
+// Preconditions: None
+// Postconditions: usage includes the buffer, if any
+template <class T>
+inline void AddVector(MemoryUsage &usage, const vector<T> &items)
+{
+  AddBlock(usage, items.capacity() * sizeof(T));
+}
+
+// Name: AddHashMap(MemoryUsage&, Map&)
+// Desc: Counts an unordered_map: the bucket array and one node per entry
+//   (next pointer, cached hash and the pair). Heap memory owned by keys
+//   and values is left to the caller
+// Preconditions: None
+// Postconditions: usage includes the table
+template <class Map>
+inline void AddHashMap(MemoryUsage &usage, const Map &map)
+{
+  if (map.bucket_count() > 1) // a lone bucket is stored inside the map
+  {
+    AddBlock(usage, map.bucket_count() * sizeof(void *));
+  }
+  size_t node = sizeof(void *) + sizeof(size_t) + sizeof(typename Map::value_type);
+  usage.m_bytes += map.size() * node;
+  usage.m_allocations += map.size();
+}
+
+#endif
@@ -4,17 +4,88 @@
 ***********************************************/
 
 #include "Navigator.h"
+#include "Waypoints.h"
 using namespace std;
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <chrono>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+// Prints each waypoint on its own line for the batch waypoints command
+class PrintSink : public WaypointSink {
+ public:
+  PrintSink(ostream &output) : m_output(output) {}
+  void Write(const Waypoint *points, int count)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      m_output << "  " << points[i].m_leg + 1 << " " << points[i].m_miles << " N:" << points[i].m_north
+           << " W:" << points[i].m_west << endl;
+    }
+  }
+ private:
+  ostream &m_output;
+};
+
+// Name: CommandSkipsCatalog
+// Desc: Tells batch commands that work on stored routes, the timetable
+//   or the caches apart from those that read the airports
+// Preconditions: None
+// Postconditions: Returns true if the command can run while the
+//   catalog is still loading
+static bool CommandSkipsCatalog(const string &command)
+{
+  const string commands[] = {"quit", "routes", "delete", "waypoints", "distance", "remove", "removecode",
+                             "split", "splice", "concat", "timetable", "similar", "duplicates", "cache",
+                             "memory", "startup"};
+  for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+  {
+    if (commands[i] == command)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Name: IsNumber
+// Desc: Tells a number apart from an airport code in batch arguments
+// Preconditions: None
+// Postconditions: Returns true if all of text is a number
+static bool IsNumber(const string &text)
+{
+  char *end = nullptr;
+  strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0';
+}
 
 // Name: Navigator (string) - Overloaded Constructor
 // Desc: Creates a navigator object to manage routes
 // Preconditions:  Provided with a filename of airports to load
 // Postconditions: m_filename is populated with fileName
-Navigator::Navigator(string fileName) : m_fileName(fileName)
+Navigator::Navigator(string fileName)
+    : m_published(0), m_source(nullptr), m_output(&cout), m_distanceCache(CACHE_DEFAULT_BYTES / 2),
+      m_pathCache(CACHE_DEFAULT_BYTES / 2), m_fileName(fileName), m_seenGeneration(0), m_watching(false),
+      m_loading(false), m_readyMillis(-1.0), m_announced(false)
+{
+}
+
+// Name: Navigator (Navigator*, ostream*) - Session Constructor
+// Desc: Creates a session on another navigator's catalog with its own
+//   routes, route index and output
+// Preconditions: source has loaded its catalog and outlives the
+//   session, output outlives the session
+// Postconditions: Session is ready for RunBatch
+Navigator::Navigator(Navigator *source, ostream *output)
+    : m_published(0), m_source(source), m_output(output), m_distanceCache(0), m_pathCache(0),
+      m_fileName(source->m_fileName), m_watching(false), m_loading(false), m_readyMillis(-1.0),
+      m_announced(true)
 {
+  shared_ptr<Catalog> catalog = GetCatalog();
+  m_seenGeneration = (catalog == nullptr) ? 0 : catalog->GetGeneration(); // the load is not news to a new session
 }
 
 // Name: Navigator (destructor)
@@ -23,94 +94,397 @@ Navigator::Navigator(string fileName) : m_fileName(fileName)
 // Postconditions: All airports and routes are cleared
 Navigator::~Navigator()
 {
-  // Delete all dynamically allocated Airport objects
-  for (size_t i = 0; i < m_airports.size(); i++)
+  StopWatching(); // The watcher must not publish while we tear down
+  if (m_loader.joinable())
+  {
+    m_loader.join(); // nor the loader, which may still be building indexes
+  }
+
+  // Dropping the last reference to the snapshot deletes its Airport objects
+  atomic_store(&m_catalog, shared_ptr<Catalog>());
+  if (m_source == nullptr) // a session only drops its reference to the shared airports
   {
-    delete m_airports[i]; // Delete the dynamically allocated Airport object
+    *m_output << "Deleting Airports" << endl;
   }
-  m_airports.clear(); // Clear the vector after deleting all Airport objects
-  cout << "Deleting Airports" << endl;
   // Delete all dynamically allocated Route objects
   for (size_t i = 0; i < m_routes.size(); i++)
   {
     delete m_routes[i]; // Delete the dynamically allocated Route object
   }
   m_routes.clear(); // Clear the vector after deleting all Route objects
-  cout << "Deleting Routes" << endl;
+  *m_output << "Deleting Routes" << endl;
 }
 
 // Name: ReadFile
 // Desc: Reads in a file that has data about each airport
 //   including code, name, city, country, degrees north and degrees west.
-//   Dynamically allocates airports and stores them in m_airports
-//   The vector can hold many airports.
+//   Dynamically allocates airports and stores them in a Catalog
+//   snapshot which is published as m_catalog
 // Preconditions: Valid file name of airports
 // Postconditions: Dynamically allocates each airport
-//   and enters it into m_airports
+//   and publishes the first catalog snapshot
 void Navigator::ReadFile()
 {
-  ifstream file(m_fileName);
-  if (!file.is_open()) // file failed to open
+  shared_ptr<Catalog> catalog = make_shared<Catalog>();
+  if (!catalog->Load(m_fileName, nullptr))
   {
-    cerr << "Unable to open file: " << m_fileName << endl;
-    return; // Return if the file cannot be opened
+    return; // Load already reported the file that failed to open
   }
 
   cout << "Opened File" << endl;
-  string line; // used to store each line read from the file
-  while (getline(file, line))
+  PublishCatalog(catalog);                                  // publish the first snapshot
+  m_seenGeneration = catalog->GetGeneration();              // nothing to report for the first load
+  m_announced = true;
+  cout << "Airports loaded: " << catalog->GetSize() << endl; // report the number of airports loaded
+}
+
+// Name: StartLoading
+// Desc: Reads m_fileName on a background thread, publishing the
+//   snapshot before its indexes are built
+// Preconditions: m_fileName is populated
+// Postconditions: Loader thread is running
+void Navigator::StartLoading()
+{
+  if (m_loader.joinable())
+  {
+    return;
+  }
+  m_loading = true; // before the thread exists, so no lock is needed
+  m_loadStart = chrono::steady_clock::now();
+  m_loader = thread(&Navigator::LoadLoop, this);
+}
+
+// Name: LoadLoop
+// Desc: Reads and publishes the first snapshot, wakes WaitForCatalog,
+//   then builds the snapshot's indexes
+// Preconditions: m_loading is true
+// Postconditions: m_loading is false, the indexes are built. A file
+//   that fails to open or parse is reported and nothing is published
+void Navigator::LoadLoop()
+{
+  shared_ptr<Catalog> catalog = make_shared<Catalog>();
+  bool loaded = false;
+  try
+  {
+    loaded = catalog->Load(m_fileName, nullptr); // reports a file that fails to open
+  }
+  catch (const exception &)
+  {
+    cerr << "Catalog not loaded, bad line in " << m_fileName << endl; // WaitForCatalog still wakes up
+  }
+  if (loaded)
+  {
+    loaded = PublishCatalog(catalog);
+  }
+  {
+    lock_guard<mutex> hold(m_loadLock);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - m_loadStart;
+    m_readyMillis = elapsed.count();
+    m_loading = false;
+  }
+  m_loadDone.notify_all();
+  if (loaded)
+  {
+    catalog->BuildIndexes(); // queries are being answered meanwhile
+  }
+}
+
+// Name: PublishCatalog
+// Desc: Publishes a snapshot unless one of the same or a newer
+//   generation is already published. The store and m_published
+//   change together under m_publishLock
+// Preconditions: catalog was loaded
+// Postconditions: Returns true if catalog is now the published snapshot
+bool Navigator::PublishCatalog(shared_ptr<Catalog> catalog)
+{
+  lock_guard<mutex> hold(m_publishLock);
+  if (m_published >= catalog->GetGeneration())
+  {
+    return false; // a newer snapshot won, keep it
+  }
+  // Readers that already hold the old snapshot keep using it until they drop it
+  atomic_store(&m_catalog, catalog);
+  m_published = catalog->GetGeneration(); // after the store, so a session that sees it finds the snapshot
+  return true;
+}
+
+// Name: WaitForCatalog
+// Desc: Waits for a background load to publish the first snapshot and
+//   announces it the first time
+// Preconditions: None
+// Postconditions: Returns the published snapshot, nullptr if the
+//   file could not be read
+shared_ptr<Catalog> Navigator::WaitForCatalog()
+{
+  {
+    unique_lock<mutex> hold(m_loadLock);
+    m_loadDone.wait(hold, [this]() { return !m_loading; });
+  }
+  shared_ptr<Catalog> catalog = GetCatalog();
+  if (catalog != nullptr && !m_announced)
+  {
+    // Reported here rather than by the loader so the lines land in the
+    // same place in the output however long the load took
+    m_announced = true;
+    if (m_seenGeneration == 0)
+    {
+      m_seenGeneration = catalog->GetGeneration();
+    }
+    *m_output << "Opened File" << endl;
+    *m_output << "Airports loaded: " << catalog->GetSize() << endl;
+  }
+  return catalog;
+}
+
+// Name: DisplayStartup
+// Desc: Displays when the catalog was ready and how long each index took
+// Preconditions: None
+// Postconditions: Startup report is displayed
+void Navigator::DisplayStartup()
+{
+  Navigator *owner = (m_source == nullptr) ? this : m_source;
+  bool loading = false;
+  double ready = -1.0;
+  {
+    lock_guard<mutex> hold(owner->m_loadLock);
+    loading = owner->m_loading;
+    ready = owner->m_readyMillis;
+  }
+  shared_ptr<Catalog> catalog = GetCatalog();
+  if (catalog == nullptr)
+  {
+    *m_output << "Catalog: " << (loading ? "loading" : "not loaded") << endl;
+    return;
+  }
+  *m_output << "Catalog: " << catalog->GetSize() << " airports read in " << catalog->GetReport().m_millis << " ms";
+  if (ready >= 0.0)
+  {
+    *m_output << ", ready for queries " << ready << " ms after start";
+  }
+  *m_output << endl;
+  const string names[] = {"Search index", "Grid"};
+  const double millis[] = {catalog->GetSearchMillis(), catalog->GetGridMillis()};
+  for (int i = 0; i < 2; i++)
+  {
+    *m_output << names[i] << ": ";
+    if (millis[i] < 0.0)
+    {
+      *m_output << "not built yet (building in the background or on first use)" << endl;
+    }
+    else
+    {
+      *m_output << "built in " << millis[i] << " ms" << endl;
+    }
+  }
+}
+
+// Name: GetCatalog
+// Desc: Returns the current catalog snapshot. The snapshot stays
+//   valid for as long as the caller holds it, even if a reload
+//   publishes a newer one in the meantime. A session checks the
+//   source's published generation (one atomic read) and only loads
+//   the shared pointer again when it moved
+// Preconditions: None
+// Postconditions: Returns the published snapshot (may be nullptr
+//   before ReadFile)
+shared_ptr<Catalog> Navigator::GetCatalog()
+{
+  if (m_source == nullptr)
+  {
+    return atomic_load(&m_catalog);
+  }
+  // Session: m_catalog belongs to this session's thread alone
+  if (m_catalog == nullptr || m_catalog->GetGeneration() != m_source->m_published)
+  {
+    m_catalog = m_source->GetCatalog();
+  }
+  return m_catalog;
+}
+
+// Name: ReloadCatalog
+// Desc: Builds a new snapshot from m_fileName, parsing only lines that
+//   changed since the current snapshot, and publishes it atomically.
+//   Waits for a background load to publish first, so the reload
+//   builds on that snapshot instead of racing it
+// Preconditions: None
+// Postconditions: Returns true if a new snapshot was published, its
+//   indexes are then built on the calling (watcher) thread.
+//   A file that fails to open or parse keeps the current snapshot
+bool Navigator::ReloadCatalog()
+{
+  {
+    unique_lock<mutex> hold(m_loadLock);
+    m_loadDone.wait(hold, [this]() { return !m_loading; });
+  }
+  shared_ptr<Catalog> current = GetCatalog();
+  shared_ptr<Catalog> next = make_shared<Catalog>();
+  try
   {
-    if (line.empty())
+    if (!next->Load(m_fileName, current.get()))
     {
-      cout << "Encountered an empty line, stopping file reading." << endl;
-      return; // exit function
+      return false;
     }
+  }
+  catch (const exception &)
+  {
+    // A half written file can leave a line that does not parse
+    cerr << "Catalog reload skipped, bad line in " << m_fileName << endl;
+    return false;
+  }
+  if (!PublishCatalog(next))
+  {
+    return false;
+  }
+  next->BuildIndexes(); // here on the watcher thread, not in a user's first query
+  return true;
+}
+
+// Name: StartWatching
+// Desc: Starts a background thread that watches m_fileName with
+//   inotify and calls ReloadCatalog whenever the file is rewritten
+// Preconditions: None (a reload waits for a background load to publish)
+// Postconditions: Watcher thread is running
+void Navigator::StartWatching()
+{
+  if (m_watching)
+  {
+    return;
+  }
+  m_watching = true;
+  m_watcher = thread(&Navigator::WatchLoop, this);
+}
 
-    // Parse the line to extract airport details using ',' as the delimiter.
-    size_t pos = 0;                            // position in string to start searching for the next comma
-    size_t end = line.find(',', pos);          // find the first comma in the line
-    string code = line.substr(pos, end - pos); // extract airport code
+// Name: StopWatching
+// Desc: Stops and joins the watcher thread
+// Preconditions: None
+// Postconditions: Watcher thread is not running
+void Navigator::StopWatching()
+{
+  m_watching = false;
+  if (m_watcher.joinable())
+  {
+    m_watcher.join();
+  }
+}
 
-    pos = end + 1;
-    end = line.find(',', pos);
-    string name = line.substr(pos, end - pos);
+// Name: WatchLoop
+// Desc: Body of the watcher thread
+// Preconditions: m_watching is true
+// Postconditions: Returns once m_watching is false
+void Navigator::WatchLoop()
+{
+  // Watch the directory instead of the file so editors that save by
+  // writing a new file and renaming it over the old one are still seen
+  size_t slash = m_fileName.rfind('/');
+  string directory = (slash == string::npos) ? "." : m_fileName.substr(0, slash + 1);
+  string baseName = (slash == string::npos) ? m_fileName : m_fileName.substr(slash + 1);
 
-    pos = end + 1;
-    end = line.find(',', pos);
-    string city = line.substr(pos, end - pos);
+  int fd = inotify_init1(IN_NONBLOCK);
+  if (fd < 0 || inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+  {
+    cerr << "Unable to watch " << m_fileName << " for changes" << endl;
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return;
+  }
 
-    pos = end + 1;
-    end = line.find(',', pos);
-    string country = line.substr(pos, end - pos);
+  char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  while (m_watching)
+  {
+    pollfd waiting = {fd, POLLIN, 0};
+    if (poll(&waiting, 1, 200) <= 0) // wake up regularly to check m_watching
+    {
+      continue;
+    }
 
-    pos = end + 1;
-    end = line.find(',', pos);
-    string tempNorth = line.substr(pos, end - pos);
-    double north = stod(tempNorth); // Direct conversion, handles negative
+    bool touched = false;
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+      for (char *next = buffer; next < buffer + length;)
+      {
+        inotify_event *event = reinterpret_cast<inotify_event *>(next);
+        if (event->len > 0 && baseName == event->name)
+        {
+          touched = true;
+        }
+        next += sizeof(inotify_event) + event->len;
+      }
+    }
+    if (touched)
+    {
+      ReloadCatalog();
+    }
+  }
+  close(fd);
+}
 
-    pos = end + 1;
-    string tempWest = line.substr(pos); // No need to find next comma, it's the rest of the string
-    double west = stod(tempWest);       // Direct conversion, handles negative
+// Name: CheckReload
+// Desc: Reports a catalog reload (latency and diff) that happened since
+//   the last check and lists stored routes whose airports (matched by
+//   stable id) were changed or removed by it
+// Preconditions: None
+// Postconditions: m_seenGeneration matches the published snapshot
+void Navigator::CheckReload()
+{
+  shared_ptr<Catalog> catalog = GetCatalog();
+  if (catalog == nullptr || catalog->GetGeneration() == m_seenGeneration)
+  {
+    return;
+  }
+  if (m_seenGeneration == 0)
+  {
+    m_seenGeneration = catalog->GetGeneration(); // the first load, WaitForCatalog announces it
+    return;
+  }
+  unsigned long reloads = catalog->GetGeneration() - m_seenGeneration;
+  m_seenGeneration = catalog->GetGeneration();
 
-    // Create a new Airport object with the parsed data.
-    Airport *newAirport = new Airport(code, name, city, country, north, west);
-    m_airports.push_back(newAirport); // add newly created Airport object to the vector of airports
+  // Each snapshot only knows its diff against the one before it
+  ReloadReport report = catalog->GetReport();
+  if (reloads > 1)
+  {
+    *m_output << "Catalog reloaded " << reloads << " times, latest shown" << endl;
   }
+  *m_output << "Catalog reloaded in " << report.m_millis << " ms: "
+       << report.m_added << " added, " << report.m_removed << " removed, "
+       << report.m_changed << " changed, " << report.m_unchanged << " unchanged" << endl;
 
-  file.close();                                             // Close the file after reading its contents
-  cout << "Airports loaded: " << m_airports.size() << endl; // report the number of airports loaded
+  // Routes keep their own copy of each stop, so they stay valid. Point out
+  // the ones whose stops no longer match the catalog.
+  for (size_t i = 0; i < m_routes.size(); i++)
+  {
+    for (int j = 0; j < m_routes[i]->GetSize(); j++)
+    {
+      Airport *stop = m_routes[i]->GetData(j);
+      Airport *current = catalog->FindId(stop->GetId());
+      if (current == nullptr)
+      {
+        *m_output << "Route " << m_routes[i]->GetName() << ": " << stop->GetCode() << " is no longer in the catalog" << endl;
+      }
+      else if (current->GetNorth() != stop->GetNorth() || current->GetWest() != stop->GetWest() ||
+               current->GetNameId() != stop->GetNameId() || current->GetCityId() != stop->GetCityId() ||
+               current->GetCountryId() != stop->GetCountryId())
+      {
+        *m_output << "Route " << m_routes[i]->GetName() << ": " << stop->GetCode() << " was changed in the catalog" << endl;
+      }
+    }
+  }
 }
 
 // Name: DisplayAirports
-// Desc: Displays each airport in m_airports
-// Preconditions: At least one airport is in m_airports
+// Desc: Displays each airport in the current catalog
+// Preconditions: At least one airport is in the catalog
 // Postconditions: Displays all airports.
 //  Uses overloaded << provided in Airport.h
 void Navigator::DisplayAirports()
 {
-  for (size_t i = 0; i < m_airports.size(); i++)
+  shared_ptr<Catalog> catalog = WaitForCatalog(); // one snapshot for the whole listing
+  for (int i = 0; catalog != nullptr && i < catalog->GetSize(); i++)
   {
-    cout << i + 1 << "." << *(m_airports[i]) << endl;
+    cout << i + 1 << "." << *(catalog->GetAirport(i)) << endl;
   }
 }
 
@@ -125,8 +499,23 @@ void Navigator::DisplayAirports()
 // Postconditions: Inserts a new route into m_routes
 void Navigator::InsertNewRoute()
 {
-  // Display all available airports for selection
-  DisplayAirports();
+  // Use one snapshot for the whole route so the numbers the user sees
+  // keep meaning the same airports even if the catalog is reloaded
+  shared_ptr<Catalog> catalog = WaitForCatalog();
+  if (catalog == nullptr)
+  {
+    cout << "No airports loaded." << endl;
+    return;
+  }
+
+  // Display all available airports for selection (large catalogs are searched instead)
+  if (catalog->GetSize() <= LIST_MAX)
+  {
+    for (int i = 0; i < catalog->GetSize(); i++)
+    {
+      cout << i + 1 << "." << *(catalog->GetAirport(i)) << endl;
+    }
+  }
 
   // Dynamically allocate a new Route object on the heap
   Route *newRoute = new Route();
@@ -134,14 +523,26 @@ void Navigator::InsertNewRoute()
   string startCityName, endCityName; // Strings to hold the names of the first and last cities added to the route
 
   int airportIndex; // Variable to hold the user's choice of airport index
+  string entry;     // What the user typed, either a number or a search
 
   int airportsAdded = 0;
   bool addingAirports = true;
 
   while (addingAirports)
   {
-    cout << "Enter the number of the airport to add to your Route: (-1 to end)" << endl;
-    cin >> airportIndex;
+    cout << "Enter the number of the airport to add to your Route: (-1 to end, or a code, name or city to search)" << endl;
+    if (!(cin >> entry))
+    {
+      break; // input ended, the route is checked below
+    }
+
+    // Anything that is not a number is a search, list the matches with their numbers
+    if (entry.find_first_not_of("-0123456789") != string::npos || entry == "-")
+    {
+      DisplayMatches(catalog, entry);
+      continue;
+    }
+    airportIndex = atoi(entry.c_str());
 
     // Check if the user wants to end the airport addition process
     if (airportIndex == -1)
@@ -157,11 +558,11 @@ void Navigator::InsertNewRoute()
         addingAirports = false;
       }
     }
-    else if (airportIndex > 0 && airportIndex <= static_cast<int>(m_airports.size()))
+    else if (airportIndex > 0 && airportIndex <= catalog->GetSize())
     {
       // The user has entered a valid airport index; proceed to add the selected airport to the route
-      Airport *selectedAirport = m_airports[airportIndex - 1];
-      newRoute->InsertEnd(selectedAirport->GetCode(), selectedAirport->GetName(), selectedAirport->GetCity(), selectedAirport->GetCountry(), selectedAirport->GetNorth(), selectedAirport->GetWest());
+      Airport *selectedAirport = catalog->GetAirport(airportIndex - 1);
+      newRoute->InsertEnd(*selectedAirport);
       airportsAdded++; // Increment the counter for added airports
 
       if (airportsAdded == 1)
@@ -182,6 +583,7 @@ void Navigator::InsertNewRoute()
     // Set the route's name based on the first and last cities added
     newRoute->SetName(startCityName + " to " + endCityName);
     // Add the newly created route to the vector of routes in the Navigator
+    newRoute->SetIndex(&m_routeIndex);
     m_routes.push_back(newRoute);
     cout << "Done Building a New Route named: " << newRoute->GetName() << endl;
   }
@@ -193,6 +595,27 @@ void Navigator::InsertNewRoute()
   }
 }
 
+// Name: DisplayMatches
+// Desc: Displays the ranked search matches for a query, numbered the
+//   same way as DisplayAirports so the number can be entered directly
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: Displays up to SEARCH_LIMIT matches
+void Navigator::DisplayMatches(shared_ptr<Catalog> catalog, string query)
+{
+  vector<SearchMatch> matches = catalog->Search(query, SEARCH_LIMIT);
+  if (matches.empty())
+  {
+    *m_output << "No airports match " << query << endl;
+    return;
+  }
+  for (size_t i = 0; i < matches.size(); i++)
+  {
+    Airport *airport = catalog->GetAirport(matches[i].m_index);
+    *m_output << matches[i].m_index + 1 << "." << airport->GetCode() << " " << *airport
+         << ", " << airport->GetCountry() << endl;
+  }
+}
+
 // Name: DisplayRoute
 // Desc: Using ChooseRoute, displays a numbered list of all routes.
 //    If no routes, indicates that there are no routes to display
@@ -231,153 +654,924 @@ void Navigator::DisplayRoute()
 // Desc: Calculates the total distance of a route
 // Goes from airport 1 to airport 2 then airport 2 to airport 3
 //  and repeats for length of route.
-//  Calculates the distance using CalcDistance (provided)
-//  Aggregates the total and returns the total in miles
+//  Calculates the distance with DefaultDistance (Haversine, the
+//  same formula as CalcDistance, unless built with DISTANCE_MODEL)
+//  Aggregates the total and returns the total in miles.
+//  Route keeps the total current as it is edited, so this is O(1)
 // Preconditions: Populated route with more than one airport
 // Postconditions: Returns the total miles between all airports in a route
 double Navigator::RouteDistance(Route *route)
 {
-  double totalDistance = 0.0; // Initialize total distance to zero.
+  return (route == nullptr) ? 0.0 : route->GetMiles();
+}
 
-  // Check if the route pointer is null or if the route has fewer than 2 airports.
-  // A valid route for distance calculation requires at least two airports.
-  if (route == nullptr || route->GetSize() < 2)
+// Name: AirportsNear
+// Desc: Finds every airport of a snapshot within a distance of a point.
+//   Candidates come from the catalog grid, are filtered with the
+//   Equirectangular model and only the ones near the edge are checked
+//   with Haversine (the same answer CalcDistance would give).
+//   Static so shard workers (ShardSet) can use it without a Navigator
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: Returns the airport indexes within miles
+vector<int> Navigator::AirportsNear(shared_ptr<Catalog> catalog, double north, double west, double miles)
+{
+  // Degrees of latitude covered by the radius, widened for longitude by
+  // the narrowest parallel the box reaches (the whole ring near a pole)
+  double northSpan = miles / EARTH_RADIUS * RAD_2_DEG;
+  double widest = fabs(north) + northSpan;
+  double westSpan = 360.0;
+  if (widest < 89.0)
   {
-    return totalDistance; // Return 0.0 if the route is invalid for distance calculation.
+    westSpan = northSpan / cos(widest * DEG_2_RAD);
   }
 
-  // Iterate over each pair of consecutive airports in the route to calculate the total distance.
-  for (int i = 0; i < route->GetSize() - 1; i++)
+  vector<int> candidates = catalog->InBox(north, west, northSpan, westSpan);
+  vector<int> found;
+  for (size_t i = 0; i < candidates.size(); i++)
   {
-    // Retrieve the current airport and the next airport in the route for distance calculation.
-    Airport *currentAirport = route->GetData(i);
-    Airport *nextAirport = route->GetData(i + 1);
-
-    // Calculate the distance between the current airport and the next airport using their geographic coordinates.
-    // The CalcDistance method is assumed to calculate the distance based on latitude (north) and longitude (west).
-    double distance = CalcDistance(currentAirport->GetNorth(), currentAirport->GetWest(),
-                                   nextAirport->GetNorth(), nextAirport->GetWest());
-
-    // Add the calculated distance to the total distance of the route.
-    totalDistance += distance;
+    Airport *airport = catalog->GetAirport(candidates[i]);
+    if (TwoStage<Equirectangular, Haversine>::Within(north, west, airport->GetNorth(), airport->GetWest(), miles))
+    {
+      found.push_back(candidates[i]);
+    }
   }
+  return found;
+}
 
-  // After iterating through all pairs of airports, return the total distance of the route.
-  return totalDistance;
+// Name: RoutesAt
+// Desc: Returns every stored route that stops at an airport
+// Preconditions: None
+// Postconditions: Returns the routes from m_routeIndex
+vector<Route *> Navigator::RoutesAt(int airportId)
+{
+  return m_routeIndex.RoutesAt(airportId);
 }
 
-// Name: ChooseRoute
-// Desc: Allows user to choose a specific route to work with
-//   by displaying numbered list
-// Preconditions: Populated m_routes
-// Postconditions: Returns the index of the selected route minus 1
-int Navigator::ChooseRoute()
+// Name: RoutesNear
+// Desc: Returns every stored route with a stop within a distance of a
+//   point (for example a closed airport). Each route is listed once
+// Preconditions: Populated catalog
+// Postconditions: Returns the affected routes
+vector<Route *> Navigator::RoutesNear(double north, double west, double miles)
 {
-  if (m_routes.empty())
+  shared_ptr<Catalog> catalog = GetCatalog();
+  vector<int> nearby = AirportsNear(catalog, north, west, miles);
+
+  vector<Route *> routes;
+  unordered_map<Route *, bool> listed; // a route near two airports is listed once
+  for (size_t i = 0; i < nearby.size(); i++)
   {
-    cout << "No routes available." << endl;
-    return -1; // Return an invalid index if no routes are available
+    vector<Route *> touching = m_routeIndex.RoutesAt(catalog->GetAirport(nearby[i])->GetId());
+    for (size_t j = 0; j < touching.size(); j++)
+    {
+      if (!listed[touching[j]])
+      {
+        listed[touching[j]] = true;
+        routes.push_back(touching[j]);
+      }
+    }
   }
+  return routes;
+}
 
-  int choice = -1;
-  bool validChoice = false; // Bool flag to control the loop
+// Name: BuildLegGraph
+// Desc: Builds the graph of every pair of airports at most maxLeg
+//   miles apart, using AirportsNear so only nearby cells are checked
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: graph holds one entry per catalog airport. Throws
+//   length_error if the legs do not fit (offsets are size_t, so a
+//   graph over INT_MAX legs is fine)
+void Navigator::BuildLegGraph(shared_ptr<Catalog> catalog, double maxLeg, LegGraph &graph)
+{
+  vector<Leg> legs;
+  for (int i = 0; i < catalog->GetSize(); i++)
+  {
+    Airport *from = catalog->GetAirport(i);
+    vector<int> nearby = AirportsNear(catalog, from->GetNorth(), from->GetWest(), maxLeg);
+    legs.clear();
+    for (size_t j = 0; j < nearby.size(); j++)
+    {
+      if (nearby[j] == i)
+      {
+        continue; // no legs back to the same airport
+      }
+      Airport *to = catalog->GetAirport(nearby[j]);
+      Leg leg;
+      leg.m_to = nearby[j];
+      leg.m_miles = CalcDistance(from->GetNorth(), from->GetWest(), to->GetNorth(), to->GetWest());
+      legs.push_back(leg);
+    }
+    graph.AddAirport(legs);
+  }
+}
 
-  while (!validChoice)
+// Name: GetLegGraph
+// Desc: Returns the leg graph of a snapshot for maxLeg, building it
+//   with BuildLegGraph only the first time. Graphs are kept on the
+//   source navigator, so sessions share them. The lock only covers
+//   finding or adding the entry, the build runs outside it
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: Returns a graph that stays valid while it is held.
+//   buildMillis is the time spent building or waiting for the graph
+//   (0 if it was ready)
+shared_ptr<LegGraph> Navigator::GetLegGraph(shared_ptr<Catalog> catalog, double maxLeg, double &buildMillis)
+{
+  Navigator *owner = (m_source == nullptr) ? this : m_source;
+  unsigned long generation = catalog->GetGeneration();
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  buildMillis = 0.0;
+  promise<shared_ptr<LegGraph> > building;
+  shared_future<shared_ptr<LegGraph> > found;
+  bool keep = true;
   {
-    cout << "Choose a route:" << endl;
-    for (size_t i = 0; i < m_routes.size(); i++)
+    lock_guard<mutex> hold(owner->m_graphLock);
+    vector<CachedLegGraph> &graphs = owner->m_legGraphs;
+    for (size_t i = 0; i < graphs.size() && !found.valid(); i++)
     {
-      // Display each route's name.
-      cout << i + 1 << ": " << m_routes[i]->GetName() << endl;
+      if (graphs[i].m_generation == generation && graphs[i].m_maxLeg == maxLeg)
+      {
+        CachedLegGraph entry = graphs[i];
+        graphs.erase(graphs.begin() + i);
+        graphs.push_back(entry); // most recently used last
+        found = entry.m_graph;
+      }
     }
-    cout << "Which route would you like to use?" << endl;
-    cin >> choice;
 
-    // Validate the choice is within the range of available routes.
-    if (choice < 1 || choice > static_cast<int>(m_routes.size()))
+    if (!found.valid() && !graphs.empty() && generation < graphs.back().m_generation)
     {
-      cout << "Invalid choice, please enter a number between 1 and " << m_routes.size() << ". Try again." << endl;
-      // validChoice remains false, so the loop continues
+      keep = false; // a reader on an old snapshot, not worth keeping
     }
-    else
+    else if (!found.valid())
     {
-      validChoice = true; // A valid choice was made, so update the flag to exit the loop
+      for (size_t i = graphs.size(); i > 0; i--)
+      {
+        if (graphs[i - 1].m_generation != generation)
+        {
+          graphs.erase(graphs.begin() + (i - 1)); // the catalog changed
+        }
+      }
+      if (graphs.size() >= LEG_GRAPHS_KEPT)
+      {
+        graphs.erase(graphs.begin());
+      }
+      CachedLegGraph entry;
+      entry.m_generation = generation;
+      entry.m_maxLeg = maxLeg;
+      entry.m_graph = building.get_future().share();
+      graphs.push_back(entry);
     }
   }
-  return choice - 1; // Adjust for 0-based indexing before returning
-}
 
-// Name: RemoveAirportFromRoute()
-// Desc: Using ChooseRoute, displays a numbered list of all routes. User selects one of the routes to remove an airport from. Displays a numbered list of all airports in selected route. User selects airport to remove from list. Each route has a minimum of two airports (will not allow). Removes airport from route if more than two. If first or last airport removed, updates name of route using UpdateName
-// Preconditions: Route has more than one airport
-// Postconditions: Displays updated route with removed airport and new name
-// Removes an airport from a user-selected route.
-void Navigator::RemoveAirportFromRoute()
-{
-  // Check if there are any routes to remove airports from
-  if (m_routes.empty())
+  if (found.valid())
   {
-    cout << "No routes to remove airports" << endl;
-    return; // Early return if there are no routes
+    if (found.wait_for(chrono::seconds(0)) != future_status::ready)
+    {
+      found.wait(); // another thread is building it
+      buildMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    return found.get(); // rethrows if that build failed
   }
 
-  // user chooses a route from the list
-  int routeIndex = ChooseRoute();
-  // Validate the chosen route index
-  if (routeIndex < 0 || routeIndex >= static_cast<int>(m_routes.size()))
+  shared_ptr<LegGraph> graph = make_shared<LegGraph>();
+  try
   {
-    cout << "Invalid route selection." << endl;
-    return; // Return early if the selection is invalid
+    BuildLegGraph(catalog, maxLeg, *graph);
+  }
+  catch (...)
+  {
+    if (keep)
+    {
+      // Drop the entry before failing it, so a kept future always holds a graph
+      lock_guard<mutex> hold(owner->m_graphLock);
+      vector<CachedLegGraph> &graphs = owner->m_legGraphs;
+      for (size_t i = 0; i < graphs.size(); i++)
+      {
+        if (graphs[i].m_generation == generation && graphs[i].m_maxLeg == maxLeg)
+        {
+          graphs.erase(graphs.begin() + i);
+          break;
+        }
+      }
+      building.set_exception(current_exception()); // threads waiting on it see the failure too
+    }
+    throw;
+  }
+  if (keep)
+  {
+    building.set_value(graph);
   }
+  buildMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  return graph;
+}
 
-  Route *selectedRoute = m_routes[routeIndex]; // Access the selected route
+// Name: BuildRoute
+// Desc: Dynamically allocates a route through catalog airports and
+//   names it after the first and last city
+// Preconditions: Every index is a position in catalog
+// Postconditions: Returns the new route, the caller owns it
+Route *Navigator::BuildRoute(shared_ptr<Catalog> catalog, const vector<int> &indexes)
+{
+  Route *newRoute = new Route();
+  for (size_t i = 0; i < indexes.size(); i++)
+  {
+    Airport *selectedAirport = catalog->GetAirport(indexes[i]);
+    newRoute->InsertEnd(*selectedAirport);
+  }
+  newRoute->NameByCities();
+  return newRoute;
+}
 
-  // Prevent removal if the route has two or fewer airports (minimum required for a valid route)
-  if (selectedRoute->GetSize() <= 2)
+// Name: ParetoRoutes
+// Desc: Finds every itinerary between two airports that no other beats
+//   on total miles, number of legs and longest leg (ParetoSearch).
+//   The budget covers the search only, the leg graph's build is reported apart
+// Preconditions: Populated catalog, codes are catalog codes
+// Postconditions: Returns one route per itinerary, fewest legs first.
+//   The caller owns the routes. timedOut is set when the time budget
+//   cut the search short, graphMillis to the time spent building or
+//   waiting for the leg graph (0 if it was ready)
+vector<Route *> Navigator::ParetoRoutes(string from, string to, ParetoOptions options, bool &timedOut,
+                                        double &graphMillis)
+{
+  vector<Route *> routes;
+  timedOut = false;
+  graphMillis = 0.0;
+  shared_ptr<Catalog> catalog = GetCatalog();
+  int origin = catalog->FindCode(from);
+  int destination = catalog->FindCode(to);
+  if (origin < 0 || destination < 0)
   {
-    cout << "Cannot remove an airport if there are two or fewer airports in the route." << endl;
-    return;
+    *m_output << "Unknown airport " << (origin < 0 ? from : to) << endl;
+    return routes;
   }
 
-  // Display the selected route's name to confirm to the user their selection
-  cout << selectedRoute->GetName() << endl;
+  // The budget and thread count only change how long the search takes
+  CacheKey key;
+  key.m_from = catalog->GetAirport(origin)->GetId();
+  key.m_to = catalog->GetAirport(destination)->GetId();
+  key.m_params = to_string(options.m_maxLeg) + " " + to_string(options.m_maxLegs);
+  vector<vector<int> > cached;
+  if (PathCache().Get(key, catalog->GetGeneration(), cached))
+  {
+    for (size_t i = 0; i < cached.size(); i++)
+    {
+      routes.push_back(BuildRoute(catalog, cached[i]));
+    }
+    return routes;
+  }
 
-  // Display airports in the selected route as a numbered list for the user to choose from
-  selectedRoute->DisplayRoute();
+  // The build cannot be cut short, so it is reported apart from the search budget
+  shared_ptr<LegGraph> graph = GetLegGraph(catalog, options.m_maxLeg, graphMillis);
 
-  int airportIndex = -1;    // Variable to store the user's choice of airport index
-  bool validChoice = false; // Bool flag to determine if a valid choice has been made
+  // Straight line miles to the destination bound what any label can still reach
+  Airport *target = catalog->GetAirport(destination);
+  vector<double> toTarget(catalog->GetSize());
+  for (int i = 0; i < catalog->GetSize(); i++)
+  {
+    Airport *airport = catalog->GetAirport(i);
+    toTarget[i] = CalcDistance(airport->GetNorth(), airport->GetWest(), target->GetNorth(), target->GetWest());
+  }
 
-  // Loop until a valid airport index is chosen by the user
-  while (!validChoice)
+  ParetoSearch search(graph.get(), options);
+  vector<ParetoPath> paths = search.Run(origin, destination, toTarget);
+  timedOut = search.TimedOut();
+  size_t bytes = 0;
+  for (size_t i = 0; i < paths.size(); i++)
+  {
+    routes.push_back(BuildRoute(catalog, paths[i].m_airports));
+    cached.push_back(paths[i].m_airports);
+    bytes += sizeof(vector<int>) + paths[i].m_airports.size() * sizeof(int);
+  }
+  if (!timedOut) // a cut short frontier may be missing itineraries
+  {
+    PathCache().Put(key, catalog->GetGeneration(), cached, bytes);
+  }
+  return routes;
+}
+
+// Name: LoadTimetable
+// Desc: Loads a timetable file and publishes it atomically. Sessions
+//   load into and read their source's timetable
+// Preconditions: None
+// Postconditions: Returns true if the file had flights. The old
+//   timetable stays when it did not
+bool Navigator::LoadTimetable(string fileName)
+{
+  ifstream file(fileName);
+  if (!file.is_open())
+  {
+    *m_output << "Could not open " << fileName << endl;
+    return false;
+  }
+  auto start = chrono::steady_clock::now();
+  shared_ptr<Timetable> timetable = make_shared<Timetable>();
+  if (!timetable->Load(file))
+  {
+    *m_output << "No flights in " << fileName << " (" << timetable->GetBadLines() << " bad lines)" << endl;
+    return false;
+  }
+  chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+  Navigator *owner = (m_source == nullptr) ? this : m_source;
+  atomic_store(&owner->m_timetable, timetable);
+  *m_output << "Timetable: " << timetable->GetConnectionCount() << " flights between " << timetable->GetAirportCount()
+            << " airports (" << timetable->GetBadLines() << " bad lines) in " << elapsed.count() << " ms" << endl;
+  return true;
+}
+
+// Name: GetTimetable
+// Desc: Returns the current timetable
+// Preconditions: None
+// Postconditions: Returns nullptr before a timetable is loaded
+shared_ptr<Timetable> Navigator::GetTimetable()
+{
+  Navigator *owner = (m_source == nullptr) ? this : m_source;
+  return atomic_load(&owner->m_timetable);
+}
+
+// Name: JourneyRoute
+// Desc: Dynamically allocates a route through the airports of a
+//   journey, named after the first and last city
+// Preconditions: journey came from timetable
+// Postconditions: Returns the new route, the caller owns it, or
+//   nullptr if a stop is not in the catalog
+Route *Navigator::JourneyRoute(shared_ptr<Catalog> catalog, shared_ptr<Timetable> timetable, const Journey &journey)
+{
+  vector<int> indexes;
+  for (size_t i = 0; i < journey.m_connections.size(); i++)
+  {
+    const Connection &connection = timetable->GetConnection(journey.m_connections[i]);
+    if (i == 0)
+    {
+      indexes.push_back(catalog->FindCode(timetable->GetCode(connection.m_from)));
+    }
+    indexes.push_back(catalog->FindCode(timetable->GetCode(connection.m_to)));
+  }
+  if (find(indexes.begin(), indexes.end(), -1) != indexes.end())
+  {
+    return nullptr;
+  }
+  return BuildRoute(catalog, indexes);
+}
+
+// Name: DisplayJourney
+// Desc: Displays every flight of a journey with its times, then the
+//   journey's route and miles
+// Preconditions: journey came from timetable
+// Postconditions: Journey is displayed
+void Navigator::DisplayJourney(shared_ptr<Catalog> catalog, shared_ptr<Timetable> timetable, const Journey &journey)
+{
+  *m_output << "  " << Timetable::FormatTime(journey.m_departure) << " to " << Timetable::FormatTime(journey.m_arrival)
+            << ":";
+  for (size_t i = 0; i < journey.m_connections.size(); i++)
+  {
+    const Connection &connection = timetable->GetConnection(journey.m_connections[i]);
+    *m_output << (i > 0 ? "," : "") << " " << timetable->GetCode(connection.m_from) << " "
+              << Timetable::FormatTime(connection.m_departure) << " " << timetable->GetCode(connection.m_to) << " "
+              << Timetable::FormatTime(connection.m_arrival);
+  }
+  *m_output << endl;
+  Route *route = JourneyRoute(catalog, timetable, journey);
+  if (route == nullptr)
   {
-    cout << "Which airport would you like to remove? (Enter number): ";
-    cin >> airportIndex;
-    airportIndex -= 1; // Adjust the user's input for 0-based indexing
+    *m_output << "    (a stop is not in the catalog)" << endl;
+    return;
+  }
+  *m_output << "    " << route->GetName() << ", " << RouteDistance(route) << " miles" << endl;
+  delete route;
+}
 
-    // Validate the chosen airport index
-    if (airportIndex >= 0 && airportIndex < selectedRoute->GetSize())
+// Name: ClusterCatalog
+// Desc: Clusters every airport of a snapshot, by k-means when k > 0,
+//   otherwise by density with airports within miles as neighbours
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: Returns the clusters, one assignment per catalog index
+Clusters Navigator::ClusterCatalog(shared_ptr<Catalog> catalog, int k, int rounds, double miles, int minPoints)
+{
+  vector<double> north(catalog->GetSize());
+  vector<double> west(catalog->GetSize());
+  for (int i = 0; i < catalog->GetSize(); i++)
+  {
+    north[i] = catalog->GetAirport(i)->GetNorth();
+    west[i] = catalog->GetAirport(i)->GetWest();
+  }
+  ClusterOptions options;
+  options.m_threads = thread::hardware_concurrency();
+  options.m_maxIterations = rounds;
+  options.m_seed = 1; // the same catalog always gives the same clusters
+  Clustering clustering(north, west, options);
+  if (k > 0)
+  {
+    return clustering.KMeans(k);
+  }
+  return clustering.Density(minPoints, [&catalog, miles](int i, vector<int> &found) {
+    Airport *airport = catalog->GetAirport(i);
+    found = AirportsNear(catalog, airport->GetNorth(), airport->GetWest(), miles);
+  });
+}
+
+// Name: ClusterAirports
+// Desc: Makes an airport of every cluster centroid, named after the
+//   member airport nearest the centroid
+// Preconditions: clusters came from catalog
+// Postconditions: Returns one airport per cluster
+vector<Airport> Navigator::ClusterAirports(shared_ptr<Catalog> catalog, const Clusters &clusters, string prefix)
+{
+  int count = clusters.m_sizes.size();
+  vector<int> nearest(count, -1);
+  vector<double> nearestMiles(count, 0.0);
+  for (int i = 0; i < catalog->GetSize(); i++)
+  {
+    int c = clusters.m_assignment[i];
+    if (c < 0)
     {
-      selectedRoute->RemoveAirport(airportIndex); // Remove the chosen airport from the route
+      continue;
+    }
+    Airport *airport = catalog->GetAirport(i);
+    double miles = CalcDistance(airport->GetNorth(), airport->GetWest(), clusters.m_north[c], clusters.m_west[c]);
+    if (nearest[c] < 0 || miles < nearestMiles[c])
+    {
+      nearest[c] = i;
+      nearestMiles[c] = miles;
+    }
+  }
+  vector<Airport> centroids;
+  for (int c = 0; c < count; c++)
+  {
+    Airport *member = (nearest[c] < 0) ? nullptr : catalog->GetAirport(nearest[c]);
+    centroids.push_back(Airport(prefix + to_string(c + 1), "CLUSTER OF " + to_string(clusters.m_sizes[c]),
+                                member == nullptr ? "" : member->GetCity(), member == nullptr ? "" : member->GetCountry(),
+                                clusters.m_north[c], clusters.m_west[c]));
+  }
+  return centroids;
+}
 
-      // Update the route's name based on the first and last airports remaining in the route
-      Airport *firstAirport = selectedRoute->GetData(0);                           // Get the first airport
-      Airport *lastAirport = selectedRoute->GetData(selectedRoute->GetSize() - 1); // Get the last airport
-      if (firstAirport && lastAirport)                                             // Check if both airports exist
+// Name: SimilarRoutes
+// Desc: Finds the stored routes shaped most like a stored route,
+//   redoing the shapes of only the routes changed or deleted since the
+//   last call
+// Preconditions: index is a position in m_routes
+// Postconditions: Returns matches whose shape numbers are positions
+//   in m_routes, nearest first (ties by position)
+vector<SimilarMatch> Navigator::SimilarRoutes(int index, SimilarOptions options)
+{
+  vector<double> north, west;
+  vector<Route *> changed, dropped;
+  m_routeIndex.TakeChanges(changed, dropped);
+  // Every old shape goes first, dropped before changed since a new
+  // route can have a deleted one's address
+  dropped.insert(dropped.end(), changed.begin(), changed.end());
+  for (size_t i = 0; i < dropped.size(); i++)
+  {
+    auto entry = m_routeShapes.find(dropped[i]);
+    if (entry != m_routeShapes.end())
+    {
+      m_shapes.Remove(entry->second);
+      m_shapeRoutes[entry->second] = nullptr;
+      m_routeShapes.erase(entry);
+    }
+  }
+  for (size_t i = 0; i < changed.size(); i++)
+  {
+    Route *route = changed[i];
+    if (route->GetSize() == 0)
+    {
+      continue; // emptied by a splice, nothing to compare
+    }
+    north.clear();
+    west.clear();
+    for (int j = 0; j < route->GetSize(); j++)
+    {
+      north.push_back(route->GetData(j)->GetNorth());
+      west.push_back(route->GetData(j)->GetWest());
+    }
+    m_routeShapes[route] = m_shapes.Add(north, west);
+    m_shapeRoutes.push_back(route);
+  }
+  if (m_shapes.GetRemovedCount() > m_shapes.GetSize() / 2)
+  {
+    vector<int> renumber = m_shapes.Compact(); // each stop is moved once per halving, so O(1) per stop added
+    vector<Route *> routes(m_shapes.GetSize());
+    for (size_t shape = 0; shape < renumber.size(); shape++)
+    {
+      if (renumber[shape] >= 0)
       {
-        // Create a new name based on the cities of the first and last airports
-        string newRouteName = firstAirport->GetCity() + " to " + lastAirport->GetCity();
-        selectedRoute->SetName(newRouteName); // Update the route's name
+        routes[renumber[shape]] = m_shapeRoutes[shape];
+        m_routeShapes[m_shapeRoutes[shape]] = renumber[shape];
       }
+    }
+    m_shapeRoutes.swap(routes);
+  }
 
-      selectedRoute->DisplayRoute(); // Display the updated route
-      cout << "Route named " << selectedRoute->GetName() << " updated" << endl;
-      validChoice = true; // Mark that a valid choice has been made, breaking the loop
+  Route *query = m_routes[index];
+  north.clear();
+  west.clear();
+  for (int j = 0; j < query->GetSize(); j++)
+  {
+    north.push_back(query->GetData(j)->GetNorth());
+    west.push_back(query->GetData(j)->GetWest());
+  }
+  auto own = m_routeShapes.find(query);
+  options.m_exclude = (own == m_routeShapes.end()) ? -1 : own->second;
+  vector<SimilarMatch> matches = m_shapes.Similar(north, west, options);
+
+  // Shape numbers to positions, in one pass over m_routes (the search
+  // already bounds every shape, so this adds no more than it costs)
+  unordered_map<Route *, int> positions;
+  for (size_t i = 0; i < matches.size(); i++)
+  {
+    positions[m_shapeRoutes[matches[i].m_shape]] = -1;
+  }
+  for (size_t i = 0; i < m_routes.size() && !positions.empty(); i++)
+  {
+    auto entry = positions.find(m_routes[i]);
+    if (entry != positions.end())
+    {
+      entry->second = i;
+    }
+  }
+  vector<SimilarMatch> found;
+  for (size_t i = 0; i < matches.size(); i++)
+  {
+    SimilarMatch match = {positions[m_shapeRoutes[matches[i].m_shape]], matches[i].m_miles};
+    if (match.m_shape >= 0) // -1 is a route missing from m_routes, never expected
+    {
+      found.push_back(match);
+    }
+  }
+  sort(found.begin(), found.end(), [](const SimilarMatch &first, const SimilarMatch &second) {
+    return (first.m_miles != second.m_miles) ? first.m_miles < second.m_miles : first.m_shape < second.m_shape;
+  });
+  return found;
+}
+
+// Name: DisplayHubs
+// Desc: Scores every airport of a snapshot on the graph of legs up to
+//   maxLeg miles (Centrality, on the shared GetLegGraph) and displays
+//   the best count airports by betweenness and by closeness
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: Both lists are displayed
+void Navigator::DisplayHubs(shared_ptr<Catalog> catalog, double maxLeg, int count, int samples)
+{
+  double buildMillis = 0.0;
+  shared_ptr<LegGraph> graph = GetLegGraph(catalog, maxLeg, buildMillis);
+  CentralityOptions options;
+  options.m_threads = thread::hardware_concurrency();
+  options.m_samples = samples;
+  Centrality centrality(graph.get(), options);
+  centrality.Run();
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    bool byBetweenness = (pass == 0);
+    vector<HubScore> hubs = centrality.Top(count, byBetweenness);
+    *m_output << (byBetweenness ? "Betweenness" : "Closeness") << " (legs up to " << maxLeg << " miles):" << endl;
+    for (size_t i = 0; i < hubs.size(); i++)
+    {
+      Airport *airport = catalog->GetAirport(hubs[i].m_airport);
+      *m_output << "  " << i + 1 << ". " << airport->GetCode() << " " << airport->GetCity() << ", "
+                << airport->GetCountry() << ": " << (byBetweenness ? hubs[i].m_betweenness : hubs[i].m_closeness)
+                << endl;
+    }
+  }
+}
+
+// Name: DisplayReach
+// Desc: Searches from every code at once (Reachability) on the shared
+//   graph of legs up to maxLeg miles (GetLegGraph) and displays how many airports each
+//   reaches on every hop up to maxHops, or lists them when list is set
+// Preconditions: catalog is a loaded snapshot
+// Postconditions: One line per code is displayed, unknown codes are reported
+void Navigator::DisplayReach(shared_ptr<Catalog> catalog, double maxLeg, int maxHops, const vector<string> &codes, bool list)
+{
+  vector<int> origins;
+  vector<string> known;
+  for (size_t i = 0; i < codes.size(); i++)
+  {
+    int index = catalog->FindCode(codes[i]);
+    if (index < 0)
+    {
+      *m_output << "Unknown airport " << codes[i] << endl;
+      continue;
+    }
+    origins.push_back(index);
+    known.push_back(codes[i]);
+  }
+  if (origins.empty())
+  {
+    return;
+  }
+  double buildMillis = 0.0;
+  shared_ptr<LegGraph> graph = GetLegGraph(catalog, maxLeg, buildMillis);
+  Reachability reachability(graph.get(), thread::hardware_concurrency());
+  vector<ReachResult> results = reachability.Run(origins, maxHops, list);
+
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    int total = 0;
+    *m_output << known[i] << ":";
+    for (int hop = 0; hop < maxHops; hop++)
+    {
+      total += results[i].m_counts[hop];
+      *m_output << " " << results[i].m_counts[hop];
+    }
+    *m_output << " (" << total << " airports within " << maxHops << " legs of " << maxLeg << " miles)" << endl;
+    if (!list)
+    {
+      continue;
+    }
+    size_t next = 0;
+    for (int hop = 0; hop < maxHops; hop++)
+    {
+      if (results[i].m_counts[hop] == 0)
+      {
+        continue;
+      }
+      *m_output << "  hop " << hop + 1 << ":";
+      for (int j = 0; j < results[i].m_counts[hop]; j++)
+      {
+        *m_output << " " << catalog->GetAirport(results[i].m_airports[next++])->GetCode();
+      }
+      *m_output << endl;
+    }
+  }
+}
+
+// Name: AirportMiles
+// Desc: Miles between two airports of a snapshot by stable id, the
+//   same answer as CalcDistance. Answers are kept in the shared
+//   distance cache until the catalog changes
+// Preconditions: Both ids are in catalog
+// Postconditions: Returns the miles, or -1 if an id is not in catalog
+double Navigator::AirportMiles(shared_ptr<Catalog> catalog, int fromId, int toId)
+{
+  // Distance does not depend on direction, so both orders share an entry
+  PairKey key = MakePairKey(min(fromId, toId), max(fromId, toId));
+  StoredMiles stored = 0.0;
+  if (DistanceCache().Get(key, catalog->GetGeneration(), stored))
+  {
+    return stored;
+  }
+  Airport *first = catalog->FindId(fromId);
+  Airport *second = catalog->FindId(toId);
+  if (first == nullptr || second == nullptr)
+  {
+    return -1.0;
+  }
+  stored = CalcDistance(first->GetNorth(), first->GetWest(), second->GetNorth(), second->GetWest());
+  DistanceCache().Put(key, catalog->GetGeneration(), stored, 0); // the value owns no heap
+  return stored; // the cached answer, so a hit and a miss agree
+}
+
+// Name: SetCacheBytes
+// Desc: Sets the byte budget of the result caches, half for airport
+//   distances and half for itinerary searches
+// Preconditions: None
+// Postconditions: Caches are trimmed to the new budget
+void Navigator::SetCacheBytes(size_t bytes)
+{
+  DistanceCache().SetCapacity(bytes / 2);
+  PathCache().SetCapacity(bytes / 2);
+}
+
+// Name: DisplayCache
+// Desc: Displays the counters and size of both result caches
+// Preconditions: None
+// Postconditions: Counters are displayed
+void Navigator::DisplayCache()
+{
+  const string names[] = {"distances", "itineraries"};
+  const CacheStats stats[] = {DistanceCache().GetStats(), PathCache().GetStats()};
+  for (int i = 0; i < 2; i++)
+  {
+    long lookups = stats[i].m_hits + stats[i].m_misses;
+    *m_output << names[i] << ": " << stats[i].m_hits << " hits, " << stats[i].m_misses << " misses ("
+              << (lookups > 0 ? 100.0 * stats[i].m_hits / lookups : 0.0) << "% hit), " << stats[i].m_entries
+              << " entries, " << stats[i].m_bytes << " of " << stats[i].m_capacity << " bytes, "
+              << stats[i].m_evictions << " evicted, " << stats[i].m_invalidations << " invalidated" << endl;
+  }
+}
+
+// Name: DistanceCache / PathCache
+// Desc: Return the caches this navigator uses. Sessions share the
+//   caches of their source
+// Preconditions: None
+// Postconditions: Returns a cache that outlives the navigator
+ResultCache<StoredMiles, PairKey, PairKeyHash> &Navigator::DistanceCache()
+{
+  return (m_source == nullptr) ? m_distanceCache : m_source->DistanceCache();
+}
+
+ResultCache<vector<vector<int> > > &Navigator::PathCache()
+{
+  return (m_source == nullptr) ? m_pathCache : m_source->PathCache();
+}
+
+// Name: GetMemory
+// Desc: Counts the heap held by the current catalog snapshot, the
+//   stored routes and the indexes, split by subsystem
+// Preconditions: None
+// Postconditions: Returns the report (see Memory.h)
+MemoryReport Navigator::GetMemory()
+{
+  MemoryReport report = MemoryReport();
+  shared_ptr<Catalog> catalog = GetCatalog();
+  if (catalog != nullptr)
+  {
+    AddBlock(report.m_catalog, sizeof(Catalog));
+    catalog->AddMemory(report);
+  }
+  SymbolTable::Shared().AddMemory(report.m_catalog); // text of every snapshot
+  shared_ptr<Timetable> timetable = GetTimetable();
+  if (timetable != nullptr && m_source == nullptr)
+  {
+    AddBlock(report.m_catalog, sizeof(Timetable));
+    timetable->AddMemory(report.m_catalog);
+  }
+  AddVector(report.m_routes, m_routes);
+  for (size_t i = 0; i < m_routes.size(); i++)
+  {
+    AddBlock(report.m_routes, sizeof(Route));
+    m_routes[i]->AddMemory(report.m_routes);
+  }
+  m_routeIndex.AddMemory(report.m_indexes);
+  m_shapes.AddMemory(report.m_indexes);
+  AddVector(report.m_indexes, m_shapeRoutes);
+  AddHashMap(report.m_indexes, m_routeShapes);
+  DistanceCache().AddMemory(report.m_caches);
+  PathCache().AddMemory(report.m_caches);
+  if (m_source == nullptr) // sessions use the source's graphs
+  {
+    lock_guard<mutex> hold(m_graphLock);
+    AddVector(report.m_caches, m_legGraphs);
+    for (size_t i = 0; i < m_legGraphs.size(); i++)
+    {
+      if (m_legGraphs[i].m_graph.wait_for(chrono::seconds(0)) == future_status::ready) // not still building
+      {
+        AddBlock(report.m_caches, sizeof(LegGraph));
+        m_legGraphs[i].m_graph.get()->AddMemory(report.m_caches);
+      }
+    }
+  }
+  return report;
+}
+
+// Name: DisplayMemory
+// Desc: Displays GetMemory, one line per subsystem and a total
+// Preconditions: None
+// Postconditions: Report is displayed
+void Navigator::DisplayMemory()
+{
+  MemoryReport report = GetMemory();
+  const string names[] = {"catalog", "routes", "indexes", "caches"};
+  const MemoryUsage usages[] = {report.m_catalog, report.m_routes, report.m_indexes, report.m_caches};
+  MemoryUsage total = MemoryUsage();
+  *m_output << fixed << setprecision(1);
+  for (int i = 0; i < 4; i++)
+  {
+    *m_output << setw(10) << left << names[i] << right << setw(12) << usages[i].m_bytes / 1024.0 << " KB "
+         << setw(10) << usages[i].m_allocations << " blocks" << endl;
+    total.m_bytes += usages[i].m_bytes;
+    total.m_allocations += usages[i].m_allocations;
+  }
+  *m_output << setw(10) << left << "total" << right << setw(12) << total.m_bytes / 1024.0 << " KB " << setw(10)
+       << total.m_allocations << " blocks" << endl;
+  m_output->unsetf(ios::floatfield);
+  *m_output << setprecision(6);
+}
+
+// Name: DeleteRoute
+// Desc: Deletes a stored route, which also drops it from m_routeIndex
+// Preconditions: index is a position in m_routes
+// Postconditions: m_routes has one less route
+void Navigator::DeleteRoute(int index)
+{
+  delete m_routes[index]; // the Route destructor removes its stops from the index
+  m_routes.erase(m_routes.begin() + index);
+}
+
+// Name: ChooseRoute
+// Desc: Allows user to choose a specific route to work with
+//   by displaying numbered list
+// Preconditions: Populated m_routes
+// Postconditions: Returns the index of the selected route minus 1
+int Navigator::ChooseRoute()
+{
+  if (m_routes.empty())
+  {
+    cout << "No routes available." << endl;
+    return -1; // Return an invalid index if no routes are available
+  }
+
+  int choice = -1;
+  bool validChoice = false; // Bool flag to control the loop
+
+  while (!validChoice)
+  {
+    cout << "Choose a route:" << endl;
+    for (size_t i = 0; i < m_routes.size(); i++)
+    {
+      // Display each route's name.
+      cout << i + 1 << ": " << m_routes[i]->GetName() << endl;
+    }
+    cout << "Which route would you like to use?" << endl;
+    cin >> choice;
+
+    // Validate the choice is within the range of available routes.
+    if (choice < 1 || choice > static_cast<int>(m_routes.size()))
+    {
+      cout << "Invalid choice, please enter a number between 1 and " << m_routes.size() << ". Try again." << endl;
+      // validChoice remains false, so the loop continues
     }
     else
+    {
+      validChoice = true; // A valid choice was made, so update the flag to exit the loop
+    }
+  }
+  return choice - 1; // Adjust for 0-based indexing before returning
+}
+
+// Name: RemoveAirportFromRoute()
+// Desc: Using ChooseRoute, displays a numbered list of all routes. User selects one of the routes to remove an airport from. Displays a numbered list of all airports in selected route. User selects one or more airports to remove from list. Each route has a minimum of two airports (will not allow). Removes every chosen airport in one pass (Route::RemoveAirports), which renames the route after its first and last cities
+// Preconditions: Route has more than one airport
+// Postconditions: Displays updated route with removed airport and new name
+// Removes an airport from a user-selected route.
+void Navigator::RemoveAirportFromRoute()
+{
+  // Check if there are any routes to remove airports from
+  if (m_routes.empty())
+  {
+    cout << "No routes to remove airports" << endl;
+    return; // Early return if there are no routes
+  }
+
+  // user chooses a route from the list
+  int routeIndex = ChooseRoute();
+  // Validate the chosen route index
+  if (routeIndex < 0 || routeIndex >= static_cast<int>(m_routes.size()))
+  {
+    cout << "Invalid route selection." << endl;
+    return; // Return early if the selection is invalid
+  }
+
+  Route *selectedRoute = m_routes[routeIndex]; // Access the selected route
+
+  // Prevent removal if the route has two or fewer airports (minimum required for a valid route)
+  if (selectedRoute->GetSize() <= 2)
+  {
+    cout << "Cannot remove an airport if there are two or fewer airports in the route." << endl;
+    return;
+  }
+
+  // Display the selected route's name to confirm to the user their selection
+  cout << selectedRoute->GetName() << endl;
+
+  // Display airports in the selected route as a numbered list for the user to choose from
+  selectedRoute->DisplayRoute();
+
+  bool validChoice = false; // Bool flag to determine if a valid choice has been made
+
+  // Loop until a valid set of airports is chosen by the user
+  while (!validChoice)
+  {
+    cout << "Which airports would you like to remove? (Enter numbers separated by spaces): ";
+    string line;
+    getline(cin >> ws, line);
+    istringstream numbers(line);
+    vector<int> indexes;
+    vector<bool> chosen(selectedRoute->GetSize(), false);
+    int airportIndex = 0;
+    bool inRange = true;
+    while (numbers >> airportIndex)
+    {
+      airportIndex -= 1; // Adjust the user's input for 0-based indexing
+      if (airportIndex < 0 || airportIndex >= selectedRoute->GetSize())
+      {
+        inRange = false;
+      }
+      else if (!chosen[airportIndex])
+      {
+        chosen[airportIndex] = true;
+        indexes.push_back(airportIndex);
+      }
+    }
+
+    // Validate the chosen airports, at least ROUTE_MIN have to stay
+    if (!inRange || indexes.empty())
     {
       cout << "Invalid airport selection. Please try again." << endl;
     }
+    else if (selectedRoute->GetSize() - static_cast<int>(indexes.size()) < ROUTE_MIN)
+    {
+      cout << "A route needs at least " << ROUTE_MIN << " airports. Please try again." << endl;
+    }
+    else
+    {
+      // Removes every chosen airport in one pass, the route is renamed after its new first and last cities
+      selectedRoute->RemoveAirports(indexes);
+      selectedRoute->DisplayRoute(); // Display the updated route
+      cout << "Route named " << selectedRoute->GetName() << " updated" << endl;
+      validChoice = true; // Mark that a valid choice has been made, breaking the loop
+    }
   }
 }
 
@@ -436,13 +1630,14 @@ void Navigator::ReverseRoute()
 
 // Name: MainMenu
 // Desc: Displays the main menu and manages exiting
-// Preconditions: Populated m_airports
+// Preconditions: Populated catalog
 // Postconditions: Exits when someone chooses 5
 void Navigator::MainMenu()
 {
   int choice = 0; // sets user choice to invalid choice
   do
   {
+    CheckReload(); // report a catalog reload that happened since the last prompt
     cout << "What would you like to do?:" << endl;
     cout << "1. Create new route" << endl;
     cout << "2. Display Route" << endl;
@@ -476,8 +1671,670 @@ void Navigator::MainMenu()
   } while (choice != 5); // Repeat until the user chooses to exit
 }
 
+// Name: RunBatch
+// Desc: Reads commands one per line and answers each without prompting.
+//   Blank lines and lines starting with # are skipped.
+//     search <query>     ranked airport matches
+//     route <code> ...   builds a route from airport codes
+//     routes             lists every route with its miles
+//     delete <n>         deletes route n
+//     touching <code>    routes that stop at an airport
+//     near <code> <mi>   routes with a stop within mi miles of an airport
+//     pareto <from> <to> [maxLeg] [maxLegs] [budgetMs]
+//                        itineraries trading miles, legs and longest leg
+//     waypoints <n> <mi> great circle points every mi miles along route n
+//     distance <n>       miles of route n under each distance model
+//     hubs [maxLeg] [count] [samples]
+//                        best connecting and most central airports
+//     reach [maxLeg] <hops> <code> ...
+//                        airports reached on each hop from every code
+//     reachable [maxLeg] <hops> <code>
+//                        lists those airports for one code, by hop
+//     timetable <file>   loads a flight timetable (see Timetable.h)
+//     earliest <from> <to> <time>
+//                        soonest arrival leaving at or after time
+//     profile <from> <to> <first> <last>
+//                        every best journey leaving between two times
+//     kmeans <k> [rounds]      k geographic clusters (k-means on the sphere)
+//     dbscan <mi> <minPoints>  density clusters of airports within mi miles
+//     quit               stops reading
+// Preconditions: Populated catalog
+// Postconditions: Every command up to quit or end of input is answered
+void Navigator::RunBatch(istream &input)
+{
+  string line;
+  while (getline(input, line))
+  {
+    istringstream words(line);
+    string command;
+    if (!(words >> command) || command[0] == '#')
+    {
+      continue;
+    }
+    CheckReload();
+    bool needsCatalog = !CommandSkipsCatalog(command);
+    shared_ptr<Catalog> catalog = needsCatalog ? WaitForCatalog() : GetCatalog(); // one snapshot per command
+    if (needsCatalog && catalog == nullptr)
+    {
+      *m_output << "No airports loaded." << endl;
+      break;
+    }
+
+    if (command == "quit")
+    {
+      break;
+    }
+    else if (command == "search")
+    {
+      string query;
+      getline(words >> ws, query);
+      DisplayMatches(catalog, query);
+    }
+    else if (command == "route")
+    {
+      vector<int> indexes;
+      string code;
+      while (words >> code)
+      {
+        int index = catalog->FindCode(code);
+        if (index < 0)
+        {
+          // Not a code, take the best search match instead
+          vector<SearchMatch> matches = catalog->Search(code, 1);
+          index = matches.empty() ? -1 : matches[0].m_index;
+        }
+        if (index < 0)
+        {
+          *m_output << "Unknown airport " << code << ", skipped" << endl;
+          continue;
+        }
+        indexes.push_back(index);
+      }
+      if (static_cast<int>(indexes.size()) < ROUTE_MIN)
+      {
+        *m_output << "Route creation cancelled. Not enough airports added." << endl;
+        continue;
+      }
+      Route *newRoute = BuildRoute(catalog, indexes);
+      newRoute->SetIndex(&m_routeIndex);
+      m_routes.push_back(newRoute);
+      *m_output << "Done Building a New Route named: " << newRoute->GetName() << endl;
+    }
+    else if (command == "routes")
+    {
+      for (size_t i = 0; i < m_routes.size(); i++)
+      {
+        *m_output << i + 1 << ": " << m_routes[i]->GetName() << " (" << RouteDistance(m_routes[i]) << " miles)" << endl;
+      }
+    }
+    else if (command == "delete")
+    {
+      int index = 0;
+      words >> index;
+      if (index < 1 || index > static_cast<int>(m_routes.size()))
+      {
+        *m_output << "Invalid route " << index << endl;
+        continue;
+      }
+      *m_output << "Deleted route " << m_routes[index - 1]->GetName() << endl;
+      DeleteRoute(index - 1);
+    }
+    else if (command == "touching" || command == "near")
+    {
+      string code;
+      double miles = 0.0;
+      words >> code >> miles;
+      Airport *airport = catalog->GetAirport(catalog->FindCode(code));
+      if (airport == nullptr)
+      {
+        *m_output << "Unknown airport " << code << endl;
+        continue;
+      }
+      vector<Route *> routes = (command == "touching") ? RoutesAt(airport->GetId())
+                                                       : RoutesNear(airport->GetNorth(), airport->GetWest(), miles);
+      *m_output << routes.size() << " routes" << endl;
+      for (size_t i = 0; i < routes.size(); i++)
+      {
+        *m_output << "  " << routes[i]->GetName() << endl;
+      }
+    }
+    else if (command == "pareto")
+    {
+      string from, to;
+      ParetoOptions options;
+      options.m_maxLeg = DEFAULT_MAX_LEG;
+      options.m_maxLegs = DEFAULT_MAX_LEGS;
+      options.m_budgetMillis = DEFAULT_BUDGET;
+      options.m_threads = thread::hardware_concurrency();
+      words >> from >> to;
+      words >> options.m_maxLeg >> options.m_maxLegs >> options.m_budgetMillis; // optional, defaults stay on failure
+
+      bool timedOut = false;
+      double graphMillis = 0.0;
+      vector<Route *> routes = ParetoRoutes(from, to, options, timedOut, graphMillis);
+      *m_output << routes.size() << " itineraries" << (timedOut ? " (time budget reached)" : "");
+      if (graphMillis > 0.0)
+      {
+        *m_output << " (leg graph built in " << graphMillis << " ms, outside the budget)";
+      }
+      *m_output << endl;
+      for (size_t i = 0; i < routes.size(); i++)
+      {
+        double longest = 0.0;
+        for (int j = 0; j + 1 < routes[i]->GetSize(); j++)
+        {
+          Airport *here = routes[i]->GetData(j);
+          Airport *next = routes[i]->GetData(j + 1);
+          longest = max(longest, AirportMiles(catalog, here->GetId(), next->GetId()));
+        }
+        *m_output << "  ";
+        for (int j = 0; j < routes[i]->GetSize(); j++)
+        {
+          *m_output << (j > 0 ? " " : "") << routes[i]->GetData(j)->GetCode();
+        }
+        *m_output << ": " << RouteDistance(routes[i]) << " miles, " << routes[i]->GetSize() - 1
+             << " legs, longest " << longest << endl;
+        delete routes[i];
+      }
+    }
+    else if (command == "waypoints")
+    {
+      int index = 0;
+      double spacing = 0.0;
+      words >> index >> spacing;
+      if (index < 1 || index > static_cast<int>(m_routes.size()) || spacing <= 0.0)
+      {
+        *m_output << "Usage: waypoints <route number> <miles between points>" << endl;
+        continue;
+      }
+      PrintSink printer(*m_output);
+      StreamWaypoints(m_routes[index - 1], spacing, printer);
+    }
+    else if (command == "distance")
+    {
+      int index = 0;
+      words >> index;
+      if (index < 1 || index > static_cast<int>(m_routes.size()))
+      {
+        *m_output << "Invalid route " << index << endl;
+        continue;
+      }
+      Route *route = m_routes[index - 1];
+      *m_output << route->GetName() << ": " << RouteDistanceWith<Equirectangular>(route) << " (equirectangular) "
+           << RouteDistanceWith<Haversine>(route) << " (haversine) "
+           << RouteDistanceWith<Vincenty>(route) << " (vincenty) miles" << endl;
+    }
+    else if (command == "remove" || command == "removecode" || command == "split")
+    {
+      int index = 0;
+      words >> index;
+      if (index < 1 || index > static_cast<int>(m_routes.size()))
+      {
+        *m_output << "Invalid route " << index << endl;
+        continue;
+      }
+      Route *route = m_routes[index - 1];
+      if (command == "split")
+      {
+        int stop = 0;
+        words >> stop;
+        if (stop - 1 < ROUTE_MIN || route->GetSize() - (stop - 1) < ROUTE_MIN)
+        {
+          *m_output << "Both parts need at least " << ROUTE_MIN << " airports" << endl;
+          continue;
+        }
+        Route *rest = route->Split(stop - 1);
+        m_routes.push_back(rest);
+        *m_output << "Split into " << route->GetName() << " and " << rest->GetName() << endl;
+        continue;
+      }
+
+      // Count what would go before touching the route, at least ROUTE_MIN airports stay
+      vector<int> stops;
+      int removing = 0;
+      if (command == "remove")
+      {
+        vector<bool> chosen(route->GetSize(), false);
+        int stop = 0;
+        while (words >> stop)
+        {
+          if (stop >= 1 && stop <= route->GetSize() && !chosen[stop - 1])
+          {
+            chosen[stop - 1] = true;
+            stops.push_back(stop - 1);
+          }
+        }
+        removing = stops.size();
+      }
+      string code;
+      if (command == "removecode")
+      {
+        words >> code;
+        for (int i = 0; i < route->GetSize(); i++)
+        {
+          removing += (route->GetData(i)->GetCode() == code) ? 1 : 0;
+        }
+      }
+      if (route->GetSize() - removing < ROUTE_MIN)
+      {
+        *m_output << "A route needs at least " << ROUTE_MIN << " airports" << endl;
+        continue;
+      }
+      int removed = (command == "remove") ? route->RemoveAirports(stops) : route->RemoveCode(code);
+      *m_output << "Removed " << removed << " airports, " << route->GetName() << " (" << RouteDistance(route)
+           << " miles)" << endl;
+    }
+    else if (command == "splice" || command == "concat")
+    {
+      int index = 0, stop = 0, other = 0;
+      words >> index;
+      if (command == "splice")
+      {
+        words >> stop;
+      }
+      words >> other;
+      if (index < 1 || index > static_cast<int>(m_routes.size()) || other < 1 ||
+          other > static_cast<int>(m_routes.size()) || index == other)
+      {
+        *m_output << "Usage: " << command << " <route number>" << (command == "splice" ? " <stop>" : "")
+             << " <other route number>" << endl;
+        continue;
+      }
+      Route *route = m_routes[index - 1];
+      if (command == "concat")
+      {
+        stop = route->GetSize() + 1;
+      }
+      if (stop < 1 || stop > route->GetSize() + 1)
+      {
+        *m_output << "Invalid stop " << stop << endl;
+        continue;
+      }
+      route->Splice(stop - 1, *m_routes[other - 1]);
+      DeleteRoute(other - 1); // now empty
+      *m_output << "Route named " << route->GetName() << " has " << route->GetSize() << " airports ("
+           << RouteDistance(route) << " miles)" << endl;
+    }
+    else if (command == "between")
+    {
+      string from, to;
+      words >> from >> to;
+      Airport *first = catalog->GetAirport(catalog->FindCode(from));
+      Airport *second = catalog->GetAirport(catalog->FindCode(to));
+      if (first == nullptr || second == nullptr)
+      {
+        *m_output << "Unknown airport " << (first == nullptr ? from : to) << endl;
+        continue;
+      }
+      *m_output << from << " to " << to << ": " << AirportMiles(catalog, first->GetId(), second->GetId()) << " miles"
+                << endl;
+    }
+    else if (command == "hubs")
+    {
+      double maxLeg = GRAPH_MAX_LEG;
+      int count = HUB_LIMIT;
+      int samples = 0;
+      words >> maxLeg >> count >> samples; // optional, defaults stay on failure
+      DisplayHubs(catalog, maxLeg, count, samples);
+    }
+    else if (command == "reach" || command == "reachable")
+    {
+      double maxLeg = GRAPH_MAX_LEG;
+      int maxHops = 0;
+      vector<string> codes;
+      string code;
+      while (words >> code)
+      {
+        codes.push_back(code);
+      }
+      if (codes.size() > 1 && IsNumber(codes[0]) && IsNumber(codes[1])) // the maximum leg was given
+      {
+        maxLeg = atof(codes[0].c_str());
+        codes.erase(codes.begin());
+      }
+      if (!codes.empty() && IsNumber(codes[0]))
+      {
+        maxHops = atoi(codes[0].c_str());
+        codes.erase(codes.begin());
+      }
+      if (maxLeg <= 0.0 || maxHops <= 0 || codes.empty())
+      {
+        *m_output << "Usage: " << command << " [maxLeg] <hops> <code> ..." << endl;
+        continue;
+      }
+      DisplayReach(catalog, maxLeg, maxHops, codes, command == "reachable");
+    }
+    else if (command == "timetable")
+    {
+      string fileName;
+      words >> fileName;
+      LoadTimetable(fileName);
+    }
+    else if (command == "earliest" || command == "profile")
+    {
+      shared_ptr<Timetable> timetable = GetTimetable();
+      string from, to, firstText, lastText;
+      words >> from >> to >> firstText >> lastText;
+      int first = Timetable::ParseTime(firstText);
+      int last = (command == "profile") ? Timetable::ParseTime(lastText) : first;
+      if (timetable == nullptr)
+      {
+        *m_output << "No timetable loaded" << endl;
+        continue;
+      }
+      if (first < 0 || last < 0)
+      {
+        *m_output << "Usage: earliest <from> <to> <HH:MM> or profile <from> <to> <HH:MM> <HH:MM>" << endl;
+        continue;
+      }
+      vector<Journey> journeys;
+      Journey journey;
+      if (command == "profile")
+      {
+        journeys = timetable->Profile(from, to, first, last);
+      }
+      else if (timetable->EarliestArrival(from, to, first, journey))
+      {
+        journeys.push_back(journey);
+      }
+      *m_output << journeys.size() << " journeys from " << from << " to " << to << endl;
+      for (size_t i = 0; i < journeys.size(); i++)
+      {
+        DisplayJourney(catalog, timetable, journeys[i]);
+      }
+    }
+    else if (command == "kmeans" || command == "dbscan")
+    {
+      int k = 0;
+      int rounds = CLUSTER_ITERATIONS;
+      double miles = 0.0;
+      int minPoints = 0;
+      if (command == "kmeans")
+      {
+        words >> k >> rounds;
+      }
+      else
+      {
+        words >> miles >> minPoints;
+      }
+      if ((command == "kmeans" && k < 1) || (command == "dbscan" && (miles <= 0.0 || minPoints < 1)))
+      {
+        *m_output << "Usage: kmeans <k> [rounds] or dbscan <miles> <minPoints>" << endl;
+        continue;
+      }
+      auto start = chrono::steady_clock::now();
+      Clusters clusters = ClusterCatalog(catalog, k, rounds, miles, minPoints);
+      chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+      vector<Airport> centroids = ClusterAirports(catalog, clusters, command == "kmeans" ? "K" : "D");
+      long noise = count(clusters.m_assignment.begin(), clusters.m_assignment.end(), CLUSTER_NOISE);
+      *m_output << centroids.size() << " clusters, " << noise << " airports in none";
+      if (command == "kmeans")
+      {
+        *m_output << ", " << clusters.m_iterations << " rounds";
+      }
+      *m_output << " (" << elapsed.count() << " ms)" << endl;
+
+      // Largest first
+      vector<int> order(centroids.size());
+      for (size_t i = 0; i < order.size(); i++)
+      {
+        order[i] = i;
+      }
+      sort(order.begin(), order.end(), [&clusters](int a, int b) {
+        return clusters.m_sizes[a] != clusters.m_sizes[b] ? clusters.m_sizes[a] > clusters.m_sizes[b] : a < b;
+      });
+      for (size_t i = 0; i < order.size() && i < static_cast<size_t>(HUB_LIMIT); i++)
+      {
+        Airport &centroid = centroids[order[i]];
+        *m_output << "  " << centroid.GetCode() << " " << centroid.GetName() << " near " << centroid.GetCity() << ", "
+                  << centroid.GetCountry() << " (N:" << centroid.GetNorth() << " W:" << centroid.GetWest() << ")" << endl;
+      }
+    }
+    else if (command == "similar")
+    {
+      int index = 0;
+      int count = SIMILAR_LIMIT;
+      string measure;
+      words >> index >> count >> measure;
+      if (index < 1 || index > static_cast<int>(m_routes.size()) || count < 1 || (measure != "" && measure != "dtw"))
+      {
+        *m_output << "Usage: similar <route number> [count] [dtw]" << endl;
+        continue;
+      }
+      SimilarOptions options;
+      options.m_threads = thread::hardware_concurrency();
+      options.m_count = count;
+      options.m_measure = (measure == "dtw") ? SIMILAR_DTW : SIMILAR_FRECHET;
+      options.m_maxMiles = 0.0;
+      vector<SimilarMatch> matches = SimilarRoutes(index - 1, options);
+      *m_output << "Routes like " << m_routes[index - 1]->GetName() << ":" << endl;
+      for (size_t i = 0; i < matches.size(); i++)
+      {
+        *m_output << "  " << matches[i].m_shape + 1 << ": " << m_routes[matches[i].m_shape]->GetName() << " ("
+                  << matches[i].m_miles << " miles apart)" << endl;
+      }
+    }
+    else if (command == "duplicates")
+    {
+      double miles = 0.0;
+      words >> miles;
+      if (miles <= 0.0)
+      {
+        *m_output << "Usage: duplicates <miles>" << endl;
+        continue;
+      }
+      SimilarOptions options;
+      options.m_threads = thread::hardware_concurrency();
+      options.m_count = m_routes.size();
+      options.m_measure = SIMILAR_FRECHET;
+      options.m_maxMiles = miles;
+      int pairs = 0;
+      for (size_t i = 0; i < m_routes.size(); i++)
+      {
+        vector<SimilarMatch> matches = SimilarRoutes(i, options);
+        for (size_t j = 0; j < matches.size(); j++)
+        {
+          if (matches[j].m_shape > static_cast<int>(i)) // each pair once
+          {
+            *m_output << "  " << i + 1 << " and " << matches[j].m_shape + 1 << ": " << m_routes[i]->GetName() << " / "
+                      << m_routes[matches[j].m_shape]->GetName() << " (" << matches[j].m_miles << " miles apart)"
+                      << endl;
+            pairs++;
+          }
+        }
+      }
+      *m_output << pairs << " pairs within " << miles << " miles" << endl;
+    }
+    else if (command == "cache")
+    {
+      long bytes = 0;
+      if (words >> bytes && bytes >= 0)
+      {
+        SetCacheBytes(bytes);
+      }
+      DisplayCache();
+    }
+    else if (command == "memory")
+    {
+      DisplayMemory();
+    }
+    else if (command == "startup")
+    {
+      DisplayStartup();
+    }
+    else if (command == "stats")
+    {
+      long stops = 0;
+      for (size_t i = 0; i < m_routes.size(); i++)
+      {
+        stops += m_routes[i]->GetSize();
+      }
+      MemoryReport report = GetMemory();
+      size_t bytes = report.m_catalog.m_bytes + report.m_routes.m_bytes + report.m_indexes.m_bytes + report.m_caches.m_bytes;
+      long blocks = report.m_catalog.m_allocations + report.m_routes.m_allocations + report.m_indexes.m_allocations +
+                    report.m_caches.m_allocations;
+      *m_output << "Airports: " << catalog->GetSize() << " (catalog generation " << catalog->GetGeneration() << ")" << endl;
+      *m_output << "Routes: " << m_routes.size() << " with " << stops << " stops" << endl;
+      *m_output << "Memory: " << bytes / 1024 << " KB in " << blocks << " blocks" << endl;
+      DisplayCache();
+    }
+    else
+    {
+      *m_output << "Unknown command: " << command << endl;
+    }
+  }
+}
+
+// Name: StartBatch
+// Desc: Starts loading the file in the background and answers
+//   commands from standard input
+// Preconditions: m_fileName is populated
+// Postconditions: All ports are loaded and every command is answered
+void Navigator::StartBatch()
+{
+  StartLoading();
+  RunBatch(cin);
+}
+
+// Name: StartSessions
+// Desc: Loads the file once and runs every script file as its own
+//   session, all of them in parallel
+// Preconditions: m_fileName is populated
+// Postconditions: Every script was answered
+void Navigator::StartSessions(vector<string> scripts)
+{
+  StartLoading(); // the sessions start once the airports are in, the indexes follow
+  if (WaitForCatalog() == nullptr)
+  {
+    return;
+  }
+  vector<ostringstream> outputs(scripts.size());
+  vector<thread> workers;
+  for (size_t i = 0; i < scripts.size(); i++)
+  {
+    workers.push_back(thread([this, &scripts, &outputs, i]() {
+      ifstream script(scripts[i]);
+      if (!script.is_open())
+      {
+        outputs[i] << "Unable to open file: " << scripts[i] << endl;
+        return;
+      }
+      Navigator session(this, &outputs[i]);
+      session.RunBatch(script);
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); i++)
+  {
+    workers[i].join();
+  }
+  for (size_t i = 0; i < scripts.size(); i++)
+  {
+    cout << "== Session " << i + 1 << " (" << scripts[i] << ")" << endl << outputs[i].str();
+  }
+}
+
+// Name: StartSharded
+// Desc: Splits the catalog across worker processes (ShardSet) instead
+//   of loading it here, then answers commands from standard input
+// Preconditions: m_fileName is populated
+// Postconditions: Every command is answered and the workers are stopped
+void Navigator::StartSharded(int shards)
+{
+  ShardSet shardSet;
+  if (!shardSet.Start(m_fileName, shards))
+  {
+    cout << "Could not start the shards" << endl;
+    return;
+  }
+  RunShardBatch(cin, shardSet);
+  shardSet.Stop();
+}
+
+// Name: RunShardBatch
+// Desc: Reads commands one per line and answers each from the shards
+// Preconditions: shards were started
+// Postconditions: Every command up to quit or end of input is answered
+void Navigator::RunShardBatch(istream &input, ShardSet &shards)
+{
+  string line;
+  while (getline(input, line))
+  {
+    istringstream words(line);
+    string command;
+    if (!(words >> command) || command[0] == '#')
+    {
+      continue;
+    }
+
+    if (command == "quit")
+    {
+      break;
+    }
+    else if (command == "shards")
+    {
+      const vector<ShardWorker> &workers = shards.GetWorkers();
+      for (size_t i = 0; i < workers.size(); i++)
+      {
+        *m_output << "Shard " << i + 1 << ": west " << workers[i].m_firstColumn - 180 << " to "
+             << workers[i].m_lastColumn - 180 << ", " << workers[i].m_size << " airports" << endl;
+      }
+    }
+    else if (command == "near")
+    {
+      string code;
+      double miles = 0.0;
+      words >> code >> miles;
+      ShardHit center;
+      if (!shards.Find(code, center))
+      {
+        *m_output << "Unknown airport " << code << endl;
+        continue;
+      }
+      vector<ShardHit> hits = shards.Near(center.m_airport.m_north, center.m_airport.m_west, miles);
+      *m_output << hits.size() << " airports" << endl;
+      for (size_t i = 0; i < hits.size(); i++)
+      {
+        *m_output << "  " << hits[i].m_airport.m_code << " " << hits[i].m_airport.m_city << " ("
+             << hits[i].m_miles << " miles, shard " << hits[i].m_shard + 1 << ")" << endl;
+      }
+    }
+    else if (command == "path")
+    {
+      string from, to;
+      double maxLeg = DEFAULT_MAX_LEG;
+      words >> from >> to;
+      words >> maxLeg; // optional, the default stays on failure
+      vector<ShardHit> stops = shards.Path(from, to, maxLeg);
+      if (stops.empty())
+      {
+        *m_output << "No route from " << from << " to " << to << " with legs up to " << maxLeg << " miles" << endl;
+        continue;
+      }
+      Route route; // only the stops of the answer are interned
+      for (size_t i = 0; i < stops.size(); i++)
+      {
+        FeedAirport &stop = stops[i].m_airport;
+        Airport airport(stop.m_code, stop.m_name, stop.m_city, stop.m_country, stop.m_north, stop.m_west);
+        route.InsertEnd(airport);
+      }
+      route.NameByCities();
+      *m_output << route.GetName() << ":";
+      for (size_t i = 0; i < stops.size(); i++)
+      {
+        *m_output << " " << stops[i].m_airport.m_code;
+      }
+      *m_output << " (" << RouteDistance(&route) << " miles, " << stops.size() - 1 << " legs)" << endl;
+    }
+    else
+    {
+      *m_output << "Unknown command: " << command << endl;
+    }
+  }
+}
+
 // Name: Start
-// Desc: Loads the file and calls the main menu
+// Desc: Starts loading the file in the background and calls the main
+//   menu right away
 // Preconditions: m_fileName is populated
 // Postconditions: All ports are loaded and the main menu runs
 void Navigator::Start()
@@ -486,7 +2343,9 @@ void Navigator::Start()
   {
     cout << "File name not found, exiting..." << endl;
   }
-  // If m_fileName is populated, proceed with reading the file and displaying the main menu
-  ReadFile();
+  // If m_fileName is populated, read the file in the background and display the main menu now
+  StartLoading();
+  StartWatching(); // pick up edits to the file without a restart
   MainMenu();
+  StopWatching();
 }
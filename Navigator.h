@@ -3,21 +3,49 @@
 
 #include "Airport.h"
 #include "Route.h"
+#include "DistanceModel.h"
+#include "Catalog.h"
+#include "RouteIndex.h"
+#include "SimilarityIndex.h"
+#include "LegGraph.h"
+#include "ParetoSearch.h"
+#include "Centrality.h"
+#include "Reachability.h"
+#include "Clustering.h"
+#include "ShardSet.h"
+#include "ResultCache.h"
+#include "Timetable.h"
 
 #include <fstream>
 #include <string>
 #include <iostream>
 #include <cstdlib>
 #include <vector>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <future>
 using namespace std;
 
-// Constants used for calculating distance
-#define PI 3.14159265358979323846
-#define EARTH_RADIUS 3958.8 // in miles
-#define DEG_2_RAD PI / 180
-#define RAD_2_DEG 180 / PI
 // Constants
 const int ROUTE_MIN = 2; // Minimum number of airports in a route
+const int LIST_MAX = 100; // Largest catalog listed in full when building a route
+const double DEFAULT_MAX_LEG = 500.0; // Longest leg (miles) when a search is not told otherwise (legs grow with its square)
+const int DEFAULT_MAX_LEGS = 4; // Most legs in a searched itinerary
+const double GRAPH_MAX_LEG = 150.0; // Longest leg (miles) for whole catalog analyses (hubs, reach) when not told otherwise
+const double DEFAULT_BUDGET = 1000.0; // Search time budget in milliseconds
+const size_t LEG_GRAPHS_KEPT = 4; // Leg graphs (one per maximum leg) kept for the current catalog
+
+// A leg graph built for one catalog snapshot and maximum leg
+struct CachedLegGraph {
+  unsigned long m_generation; //Catalog generation the graph was built from
+  double m_maxLeg;            //Longest leg in the graph
+  shared_future<shared_ptr<LegGraph> > m_graph; //Ready once the thread building it is done
+};
 
 class Navigator
 {
@@ -27,35 +55,193 @@ public:
   // Preconditions:  Provided with a filename of airports to load
   // Postconditions: m_filename is populated with fileName
   Navigator(string fileName);
+  // Name: Navigator (Navigator*, ostream*) - Session Constructor
+  // Desc: Creates a session on another navigator's catalog. The session
+  //   has its own routes and route index and writes batch output to
+  //   output, so many sessions can run RunBatch on their own threads.
+  //   The shared catalog is never locked: each session keeps its own
+  //   reference to the snapshot and only picks up a new one after the
+  //   source publishes a reload (see GetCatalog)
+  // Preconditions: source has loaded its catalog and outlives the
+  //   session, output outlives the session
+  // Postconditions: Session is ready for RunBatch
+  Navigator(Navigator *source, ostream *output);
   // Name: Navigator (destructor)
   // Desc: Deallocates all dynamic aspects of a Navigator
   // Preconditions: There is an existing Navigator
   // Postconditions: All airports and routes are cleared
   ~Navigator();
   // Name: Start
-  // Desc: Loads the file and calls the main menu
+  // Desc: Starts loading the file in the background (StartLoading) and
+  //   calls the main menu right away. Choices that need the airports
+  //   wait for them (WaitForCatalog), the others do not
   // Preconditions: m_fileName is populated
   // Postconditions: All ports are loaded and the main menu runs
   void Start();
   // Name: DisplayAirports
-  // Desc: Displays each airport in m_airports
-  // Preconditions: At least one airport is in m_airports
+  // Desc: Displays each airport in the current catalog
+  // Preconditions: At least one airport is in the catalog
   // Postconditions: Displays all airports.
   //  Uses overloaded << provided in Airport.h
   void DisplayAirports();
+  // Name: StartBatch
+  // Desc: Starts loading the file in the background and answers
+  //   commands from standard input instead of running the menu (see
+  //   RunBatch)
+  // Preconditions: m_fileName is populated
+  // Postconditions: All ports are loaded and every command is answered
+  void StartBatch();
+  // Name: RunBatch
+  // Desc: Reads commands one per line and answers each without prompting.
+  //   Blank lines and lines starting with # are skipped. Commands on
+  //   stored routes, the timetable and the caches are answered while
+  //   the catalog is still loading, the rest wait for it.
+  //     search <query>     ranked airport matches
+  //     route <code> ...   builds a route from airport codes
+  //     routes             lists every route with its miles
+  //     delete <n>         deletes route n
+  //     touching <code>    routes that stop at an airport
+  //     near <code> <mi>   routes with a stop within mi miles of an airport
+  //     pareto <from> <to> [maxLeg] [maxLegs] [budgetMs]
+  //                        itineraries trading miles, legs and longest leg
+  //     waypoints <n> <mi> great circle points every mi miles along route n
+  //     distance <n>       miles of route n under each distance model
+  //     remove <n> <stop> ...    removes several stops of route n at once
+  //     removecode <n> <code>    removes every stop of route n at an airport
+  //     splice <n> <stop> <m>    moves route m into route n before stop
+  //     concat <n> <m>           moves route m onto the end of route n
+  //     split <n> <stop>         route n ends before stop, the rest is a new route
+  //     between <code> <code> miles between two airports (cached)
+  //     hubs [maxLeg] [count] [samples]
+  //                        best connecting and most central airports
+  //     reach [maxLeg] <hops> <code> ...
+  //                        airports reached on each hop from every code
+  //     reachable [maxLeg] <hops> <code>
+  //                        lists those airports for one code, by hop
+  //     timetable <file>   loads a flight timetable (see Timetable.h)
+  //     earliest <from> <to> <time>
+  //                        soonest arrival leaving at or after time
+  //     profile <from> <to> <first> <last>
+  //                        every best journey leaving between two times
+  //     kmeans <k> [rounds]      k geographic clusters (k-means on the sphere)
+  //     dbscan <mi> <minPoints>  density clusters of airports within mi miles
+  //     similar <n> [count] [dtw]  stored routes shaped most like route n
+  //                        (discrete Frechet, or dynamic time warping)
+  //     duplicates <mi>    pairs of stored routes within mi miles (Frechet)
+  //     cache [bytes]      cache counters, or a new byte budget
+  //     memory             heap held by each subsystem
+  //     stats              catalog and route counts with the heap total
+  //     startup            when the catalog was ready and how long each index took
+  //     quit               stops reading
+  // Preconditions: Populated catalog
+  // Postconditions: Every command up to quit or end of input is answered
+  void RunBatch(istream &input);
+  // Name: StartSessions
+  // Desc: Loads the file once and runs every script file as its own
+  //   session (see the session constructor), all of them in parallel.
+  //   Each session's output is shown after all of them finish
+  // Preconditions: m_fileName is populated
+  // Postconditions: Every script was answered
+  void StartSessions(vector<string> scripts);
+  // Name: StartSharded
+  // Desc: Splits the catalog across worker processes (ShardSet) instead
+  //   of loading it here, then answers commands from standard input
+  //   (see RunShardBatch)
+  // Preconditions: m_fileName is populated
+  // Postconditions: Every command is answered and the workers are stopped
+  void StartSharded(int shards);
+  // Name: RunShardBatch
+  // Desc: Reads commands one per line and answers each from the shards.
+  //     shards                  band and size of every shard
+  //     near <code> <mi>        airports within mi miles of an airport
+  //     path <from> <to> [maxLeg] shortest route with no longer leg
+  //     quit                    stops reading
+  // Preconditions: shards were started
+  // Postconditions: Every command up to quit or end of input is answered
+  void RunShardBatch(istream &input, ShardSet &shards);
+  // Name: DisplayMatches
+  // Desc: Displays the ranked search matches for a query, numbered the
+  //   same way as DisplayAirports so the number can be entered directly
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: Displays up to SEARCH_LIMIT matches
+  void DisplayMatches(shared_ptr<Catalog> catalog, string query);
   // Name: ReadFile
   // Desc: Reads in a file that has data about each airport
   //   including code, name, city, country, degrees north and degrees west.
-  //   Dynamically allocates airports and stores them in m_airports
-  //   The vector can hold many airports.
+  //   Dynamically allocates airports and stores them in a Catalog
+  //   snapshot which is published as m_catalog
   // Preconditions: Valid file name of airports
   // Postconditions: Dynamically allocates each airport
-  //   and enters it into m_airports
+  //   and publishes the first catalog snapshot
   void ReadFile();
+  // Name: StartLoading
+  // Desc: Reads m_fileName on a background thread (see LoadLoop). The
+  //   snapshot is published as soon as the airports are read, then the
+  //   same thread builds its search index and grid while the caller
+  //   gets on with answering
+  // Preconditions: m_fileName is populated
+  // Postconditions: Loader thread is running
+  void StartLoading();
+  // Name: WaitForCatalog
+  // Desc: Waits for a background load to publish the first snapshot,
+  //   announcing it (as ReadFile does) the first time, and returns it.
+  //   Does not wait for the search index or grid: a query that needs
+  //   one before the loader built it builds or waits for just that one
+  // Preconditions: None
+  // Postconditions: Returns the published snapshot, nullptr if the
+  //   file could not be read
+  shared_ptr<Catalog> WaitForCatalog();
+  // Name: DisplayStartup
+  // Desc: Displays how long the airports took to read, how long after
+  //   the start they were ready for queries and how long the search
+  //   index and grid took to build (or that they are still building)
+  // Preconditions: None
+  // Postconditions: Startup report is displayed
+  void DisplayStartup();
+  // Name: GetCatalog
+  // Desc: Returns the current catalog snapshot. The snapshot stays
+  //   valid for as long as the caller holds it, even if a reload
+  //   publishes a newer one in the meantime. A session checks the
+  //   source's published generation (one atomic read) and only loads
+  //   the shared pointer again when it moved
+  // Preconditions: None
+  // Postconditions: Returns the published snapshot (may be nullptr
+  //   before ReadFile)
+  shared_ptr<Catalog> GetCatalog();
+  // Name: ReloadCatalog
+  // Desc: Builds a new snapshot from m_fileName, parsing only lines that
+  //   changed since the current snapshot, and publishes it atomically.
+  //   Waits for a background load to publish first, so the reload
+  //   builds on that snapshot instead of racing it
+  // Preconditions: None
+  // Postconditions: Returns true if a new snapshot was published, its
+  //   indexes are then built on the calling (watcher) thread.
+  //   A file that fails to open or parse keeps the current snapshot
+  bool ReloadCatalog();
+  // Name: StartWatching
+  // Desc: Starts a background thread that watches m_fileName with
+  //   inotify and calls ReloadCatalog whenever the file is rewritten
+  // Preconditions: None (a reload waits for a background load to publish)
+  // Postconditions: Watcher thread is running
+  void StartWatching();
+  // Name: StopWatching
+  // Desc: Stops and joins the watcher thread
+  // Preconditions: None
+  // Postconditions: Watcher thread is not running
+  void StopWatching();
+  // Name: CheckReload
+  // Desc: Reports a catalog reload (latency and diff) that happened since
+  //   the last check and lists stored routes whose airports (matched by
+  //   stable id) were changed or removed by it
+  // Preconditions: None
+  // Postconditions: m_seenGeneration matches the published snapshot
+  void CheckReload();
   // Name: InsertNewRoute
   // Desc: Dynamically allocates a new route with the user selecting each airport in the route. Each route can have a minimum of two
   //   airports. Will not allow a one airport route.
   //   Checks for min of two valid airports (1-40)
+  //   Typing anything other than a number searches the catalog with
+  //   DisplayMatches and the user picks from the numbered matches
   //   Route named using Route's UpdateName.
   //   For example, Baltimore to Boston
   //   Once route is created, inserted into m_routes.
@@ -64,7 +250,7 @@ public:
   void InsertNewRoute();
   // Name: MainMenu
   // Desc: Displays the main menu and manages exiting
-  // Preconditions: Populated m_airports
+  // Preconditions: Populated catalog
   // Postconditions: Exits when someone chooses 5
   void MainMenu();
   // Name: ChooseRoute
@@ -87,11 +273,10 @@ public:
   // Desc: Using ChooseRoute, displays a numbered list of all routes.
   //    User selects one of the routes to remove an airport from.
   //    Displays a numbered list of all airports in selected route.
-  //    User selects airport to remove from list.
+  //    User selects one or more airports to remove from list.
   //    Each route has a minimum of two airports (will not allow).
-  //    Removes airport from route if more than two.
-  //    If first or last airport removed,
-  //    updates name of route using UpdateName
+  //    Removes every chosen airport in one pass (Route::RemoveAirports),
+  //    which renames the route after its first and last cities
   // Preconditions: Route has more than one airport
   // Postconditions: Displays updated route with removed airport and new name
   void RemoveAirportFromRoute();
@@ -99,11 +284,196 @@ public:
   // Desc: Calculates the total distance of a route
   //    Goes from airport 1 to airport 2 then airport 2 to airport 3
   //    and repeats for length of route.
-  //    Calculates the distance using CalcDistance (provided)
-  //    Aggregates the total and returns the total in miles
+  //    Calculates the distance with DefaultDistance (Haversine, the
+  //    same formula as CalcDistance, unless built with DISTANCE_MODEL)
+  //    Aggregates the total and returns the total in miles.
+  //    Route keeps the total current as it is edited, so this is O(1)
   // Preconditions: Populated route with more than one airport
   // Postconditions: Returns the total miles between all airports in a route
   double RouteDistance(Route *);
+  // Name: RouteDistanceWith<Model>
+  // Desc: RouteDistance using a distance model chosen at compile time
+  //    (see DistanceModel.h). Walks the airports once
+  // Preconditions: None
+  // Postconditions: Returns the total miles, 0 for fewer than two airports
+  template <class Model>
+  double RouteDistanceWith(Route *route)
+  {
+    double totalDistance = 0.0;
+    if (route == nullptr || route->GetSize() < 2)
+    {
+      return totalDistance;
+    }
+    Airport *current = route->GetData(0);
+    for (Airport *next = current->GetNext(); next != nullptr; next = next->GetNext())
+    {
+      totalDistance += Model::Miles(current->GetNorth(), current->GetWest(),
+                                    next->GetNorth(), next->GetWest());
+      current = next;
+    }
+    return totalDistance;
+  }
+  // Name: AirportsNear
+  // Desc: Finds every airport of a snapshot within a distance of a point.
+  //   Candidates come from the catalog grid, are filtered with the
+  //   Equirectangular model and only the ones near the edge are checked
+  //   with Haversine (the same answer CalcDistance would give).
+  //   Static so shard workers (ShardSet) can use it without a Navigator
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: Returns the airport indexes within miles
+  static vector<int> AirportsNear(shared_ptr<Catalog> catalog, double north, double west, double miles);
+  // Name: RoutesAt
+  // Desc: Returns every stored route that stops at an airport
+  // Preconditions: None
+  // Postconditions: Returns the routes from m_routeIndex
+  vector<Route*> RoutesAt(int airportId);
+  // Name: RoutesNear
+  // Desc: Returns every stored route with a stop within a distance of a
+  //   point (for example a closed airport). Each route is listed once
+  // Preconditions: Populated catalog
+  // Postconditions: Returns the affected routes
+  vector<Route*> RoutesNear(double north, double west, double miles);
+  // Name: BuildLegGraph
+  // Desc: Builds the graph of every pair of airports at most maxLeg
+  //   miles apart, using AirportsNear so only nearby cells are checked
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: graph holds one entry per catalog airport. Throws
+  //   length_error if the legs do not fit (offsets are size_t, so a
+  //   graph over INT_MAX legs is fine)
+  void BuildLegGraph(shared_ptr<Catalog> catalog, double maxLeg, LegGraph &graph);
+  // Name: GetLegGraph
+  // Desc: Returns the leg graph of a snapshot for maxLeg, building it
+  //   with BuildLegGraph only the first time. Graphs are kept on the
+  //   source navigator, so sessions share them, LEG_GRAPHS_KEPT at most
+  //   (least recently used dropped first) and only for the newest
+  //   generation asked for. The lock only covers finding or adding the
+  //   entry: the first caller builds outside it, callers wanting the
+  //   same graph wait on its future and others are not held up
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: Returns a graph that stays valid while it is held.
+  //   buildMillis is the time spent building or waiting for the graph
+  //   (0 if it was ready)
+  shared_ptr<LegGraph> GetLegGraph(shared_ptr<Catalog> catalog, double maxLeg, double &buildMillis);
+  // Name: BuildRoute
+  // Desc: Dynamically allocates a route through catalog airports and
+  //   names it after the first and last city
+  // Preconditions: Every index is a position in catalog
+  // Postconditions: Returns the new route, the caller owns it
+  Route* BuildRoute(shared_ptr<Catalog> catalog, const vector<int> &indexes);
+  // Name: AirportMiles
+  // Desc: Miles between two airports of a snapshot by stable id, the
+  //   same answer as CalcDistance. Answers are kept in the shared
+  //   distance cache (packed id pair to StoredMiles, so float in
+  //   compact builds) until the catalog changes
+  // Preconditions: Both ids are in catalog
+  // Postconditions: Returns the miles, or -1 if an id is not in catalog
+  double AirportMiles(shared_ptr<Catalog> catalog, int fromId, int toId);
+  // Name: SetCacheBytes
+  // Desc: Sets the byte budget of the result caches, half for airport
+  //   distances and half for itinerary searches
+  // Preconditions: None
+  // Postconditions: Caches are trimmed to the new budget
+  void SetCacheBytes(size_t bytes);
+  // Name: DisplayCache
+  // Desc: Displays the counters and size of both result caches
+  // Preconditions: None
+  // Postconditions: Counters are displayed
+  void DisplayCache();
+  // Name: ParetoRoutes
+  // Desc: Finds every itinerary between two airports that no other beats
+  //   on total miles, number of legs and longest leg (ParetoSearch)
+  //   Searches that finish inside their budget are cached by airport
+  //   ids, maximum leg and maximum legs until the catalog changes.
+  //   The budget covers the search only: building the leg graph
+  //   (GetLegGraph) cannot be cut short, so its time is reported apart
+  // Preconditions: Populated catalog, codes are catalog codes
+  // Postconditions: Returns one route per itinerary, fewest legs first.
+  //   The caller owns the routes. timedOut is set when the time budget
+  //   cut the search short, graphMillis to the time spent building or
+  //   waiting for the leg graph (0 if it was ready)
+  vector<Route*> ParetoRoutes(string from, string to, ParetoOptions options, bool &timedOut, double &graphMillis);
+  // Name: DisplayHubs
+  // Desc: Scores every airport of a snapshot on the graph of legs up to
+  //   maxLeg miles (Centrality, on the shared GetLegGraph) and displays
+  //   the best count airports by betweenness and by closeness. samples
+  //   above 0 starts from that many airports only, an estimate for very
+  //   large catalogs
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: Both lists are displayed
+  void DisplayHubs(shared_ptr<Catalog> catalog, double maxLeg, int count, int samples);
+  // Name: DisplayReach
+  // Desc: Searches from every code at once (Reachability) on the shared
+  //   graph of legs up to maxLeg miles (GetLegGraph) and displays how many airports each
+  //   reaches on every hop up to maxHops, or lists them when list is set
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: One line per code is displayed, unknown codes are reported
+  void DisplayReach(shared_ptr<Catalog> catalog, double maxLeg, int maxHops, const vector<string> &codes, bool list);
+  // Name: LoadTimetable
+  // Desc: Loads a timetable file and publishes it atomically. Sessions
+  //   load into and read their source's timetable
+  // Preconditions: None
+  // Postconditions: Returns true if the file had flights. The old
+  //   timetable stays when it did not
+  bool LoadTimetable(string fileName);
+  // Name: GetTimetable
+  // Desc: Returns the current timetable
+  // Preconditions: None
+  // Postconditions: Returns nullptr before a timetable is loaded
+  shared_ptr<Timetable> GetTimetable();
+  // Name: JourneyRoute
+  // Desc: Dynamically allocates a route through the airports of a
+  //   journey, named after the first and last city
+  // Preconditions: journey came from timetable
+  // Postconditions: Returns the new route, the caller owns it, or
+  //   nullptr if a stop is not in the catalog
+  Route* JourneyRoute(shared_ptr<Catalog> catalog, shared_ptr<Timetable> timetable, const Journey &journey);
+  // Name: DisplayJourney
+  // Desc: Displays every flight of a journey with its times, then the
+  //   journey's route and miles
+  // Preconditions: journey came from timetable
+  // Postconditions: Journey is displayed
+  void DisplayJourney(shared_ptr<Catalog> catalog, shared_ptr<Timetable> timetable, const Journey &journey);
+  // Name: ClusterCatalog
+  // Desc: Clusters every airport of a snapshot (Clustering), by k-means
+  //   when k > 0, otherwise by density with airports within miles as
+  //   neighbours (AirportsNear)
+  // Preconditions: catalog is a loaded snapshot
+  // Postconditions: Returns the clusters, one assignment per catalog index
+  Clusters ClusterCatalog(shared_ptr<Catalog> catalog, int k, int rounds, double miles, int minPoints);
+  // Name: ClusterAirports
+  // Desc: Makes an airport of every cluster centroid: code prefix and
+  //   number, name CLUSTER and its size, and the city and country of
+  //   the member airport nearest the centroid
+  // Preconditions: clusters came from catalog
+  // Postconditions: Returns one airport per cluster
+  vector<Airport> ClusterAirports(shared_ptr<Catalog> catalog, const Clusters &clusters, string prefix);
+  // Name: SimilarRoutes
+  // Desc: Finds the stored routes shaped most like stored route index
+  //   (SimilarityIndex), leaving the route itself out. Only the routes
+  //   m_routeIndex reports changed or deleted since the last call are
+  //   redone: their old shapes are removed from m_shapes, the changed
+  //   ones added again at the end, and m_shapes is compacted once
+  //   removed shapes outnumber the rest
+  // Preconditions: index is a position in m_routes
+  // Postconditions: Returns matches whose shape numbers are positions
+  //   in m_routes, nearest first (ties by position)
+  vector<SimilarMatch> SimilarRoutes(int index, SimilarOptions options);
+  // Name: GetMemory
+  // Desc: Counts the heap held by the current catalog snapshot, the
+  //   stored routes and the indexes, split by subsystem
+  // Preconditions: None
+  // Postconditions: Returns the report (see Memory.h)
+  MemoryReport GetMemory();
+  // Name: DisplayMemory
+  // Desc: Displays GetMemory, one line per subsystem and a total
+  // Preconditions: None
+  // Postconditions: Report is displayed
+  void DisplayMemory();
+  // Name: DeleteRoute
+  // Desc: Deletes a stored route, which also drops it from m_routeIndex
+  // Preconditions: index is a position in m_routes
+  // Postconditions: m_routes has one less route
+  void DeleteRoute(int index);
   // Name: ReverseRoute
   // Desc: Using ChooseRoute, users chooses route and the route is reversed
   //   If no routes in m_routes, indicates no routes available to reverse
@@ -138,9 +508,60 @@ public:
   }
 
 private:
-  vector<Airport *> m_airports; // Vector of all airports
-  vector<Route *> m_routes;     // Vector of all routes
-  string m_fileName;            // File to read in
+  // Name: WatchLoop
+  // Desc: Body of the watcher thread
+  // Preconditions: m_watching is true
+  // Postconditions: Returns once m_watching is false
+  void WatchLoop();
+  // Name: LoadLoop
+  // Desc: Body of the loader thread: reads and publishes the first
+  //   snapshot, wakes WaitForCatalog, then builds the snapshot's indexes
+  // Preconditions: m_loading is true
+  // Postconditions: m_loading is false, the indexes are built. A file
+  //   that fails to open or parse is reported and nothing is published
+  void LoadLoop();
+  // Name: PublishCatalog
+  // Desc: Publishes a snapshot unless one of the same or a newer
+  //   generation is already published. The store and m_published
+  //   change together under m_publishLock, so the loader and the
+  //   watcher cannot interleave them
+  // Preconditions: catalog was loaded
+  // Postconditions: Returns true if catalog is now the published snapshot
+  bool PublishCatalog(shared_ptr<Catalog> catalog);
+  // Name: DistanceCache / PathCache
+  // Desc: Return the caches this navigator uses. Sessions share the
+  //   caches of their source
+  // Preconditions: None
+  // Postconditions: Returns a cache that outlives the navigator
+  ResultCache<StoredMiles, PairKey, PairKeyHash>& DistanceCache();
+  ResultCache<vector<vector<int> > >& PathCache();
+
+  shared_ptr<Catalog> m_catalog;  // Current catalog snapshot (read and published atomically; a session's own copy)
+  atomic<unsigned long> m_published; // Generation of the last published snapshot
+  mutex m_publishLock;            // Held while m_catalog and m_published are published together
+  Navigator *m_source;            // Navigator whose catalog a session shares (nullptr if not a session)
+  ostream *m_output;              // Where batch commands write (cout unless a session)
+  ResultCache<StoredMiles, PairKey, PairKeyHash> m_distanceCache; // Airport id pair to miles (unused by sessions)
+  ResultCache<vector<vector<int> > > m_pathCache; // Itinerary search to its paths as catalog indexes (unused by sessions)
+  mutex m_graphLock;              // Guards m_legGraphs (not held while a graph is built)
+  vector<CachedLegGraph> m_legGraphs; // Leg graphs of the newest generation, most recently used last (unused by sessions)
+  shared_ptr<Timetable> m_timetable; // Current timetable (read and published atomically; unused by sessions)
+  vector<Route *> m_routes;       // Vector of all routes
+  RouteIndex m_routeIndex;        // Airport id to the routes that stop there
+  SimilarityIndex m_shapes;       // Stops of every route in m_routes, for SimilarRoutes
+  vector<Route *> m_shapeRoutes;  // Route of every shape number in m_shapes (nullptr once removed)
+  unordered_map<Route *, int> m_routeShapes; // Shape number in m_shapes of every route with one
+  string m_fileName;              // File to read in
+  unsigned long m_seenGeneration; // Catalog generation last reported by CheckReload
+  thread m_watcher;               // Background catalog watcher
+  atomic<bool> m_watching;        // Tells the watcher to keep running
+  thread m_loader;                // Background catalog loader
+  mutex m_loadLock;               // Guards m_loading and m_readyMillis
+  condition_variable m_loadDone;  // Signalled when the loader has published (or failed)
+  bool m_loading;                 // Loader has not published yet
+  chrono::steady_clock::time_point m_loadStart; // When StartLoading was called
+  double m_readyMillis;           // Start to first snapshot published (-1 before)
+  bool m_announced;               // The first load was reported (ReadFile or WaitForCatalog)
 };
 
 #endif
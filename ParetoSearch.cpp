@@ -0,0 +1,217 @@
+/*****************************************
+** File:    ParetoSearch.cpp
+** Description: This file implements the multi criteria (miles, legs, longest leg) itinerary search
+***********************************************/
+
+#include "ParetoSearch.h"
+#include <algorithm>
+#include <thread>
+using namespace std;
+
+// Name: ParetoSearch(LegGraph*, ParetoOptions)
+// Desc: Prepares a search over a leg graph
+// Preconditions: graph stays alive while the search runs
+// Postconditions: Search is ready to run
+ParetoSearch::ParetoSearch(LegGraph *graph, ParetoOptions options)
+    : m_graph(graph), m_options(options), m_timedOut(false)
+{
+  if (m_options.m_threads < 1)
+  {
+    m_options.m_threads = 1;
+  }
+}
+
+// Name: Run(int, int, vector<double>&)
+// Desc: Label setting search, one round per leg. Each round extends the
+//   labels of the last round in parallel, then keeps only labels that
+//   no other label at the same airport beats on miles, legs and
+//   longest leg. toTarget holds the direct miles from every airport
+//   to the destination and prunes labels that cannot beat the frontier
+// Preconditions: origin and destination are airports of the graph
+// Postconditions: Returns the frontier sorted by legs, then miles.
+//   m_timedOut tells whether the budget cut the search short
+vector<ParetoPath> ParetoSearch::Run(int origin, int destination, const vector<double> &toTarget)
+{
+  m_deadline = chrono::steady_clock::now() +
+               chrono::microseconds(static_cast<long long>(m_options.m_budgetMillis * 1000.0));
+  m_timedOut = false;
+  m_labels.clear();
+  m_bags.assign(m_graph->GetSize(), vector<int>());
+
+  Label start;
+  start.m_airport = origin;
+  start.m_parent = -1;
+  start.m_legs = 0;
+  start.m_miles = 0.0;
+  start.m_longest = 0.0;
+  m_labels.push_back(start);
+  m_bags[origin].push_back(0);
+
+  vector<int> frontier(1, 0); // labels added by the last round
+  for (int round = 1; round <= m_options.m_maxLegs && !frontier.empty() && !m_timedOut; round++)
+  {
+    // Extend: every thread takes an even slice of the frontier
+    int threads = min(m_options.m_threads, static_cast<int>(frontier.size()));
+    vector<vector<Label> > found(threads);
+    vector<thread> workers;
+    int slice = (frontier.size() + threads - 1) / threads;
+    for (int t = 0; t < threads; t++)
+    {
+      int first = t * slice;
+      int last = min(first + slice, static_cast<int>(frontier.size()));
+      if (t == threads - 1)
+      {
+        Extend(frontier, first, last, destination, toTarget, found[t]); // this thread does the last slice
+      }
+      else
+      {
+        workers.push_back(thread(&ParetoSearch::Extend, this, cref(frontier), first, last, destination,
+                                 cref(toTarget), ref(found[t])));
+      }
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+      workers[t].join();
+    }
+
+    // Merge: cheapest first, so a candidate can only be beaten by what is
+    // already kept (older rounds have fewer legs and are never beaten)
+    vector<Label> candidates;
+    for (int t = 0; t < threads; t++)
+    {
+      candidates.insert(candidates.end(), found[t].begin(), found[t].end());
+    }
+    sort(candidates.begin(), candidates.end(), [](const Label &first, const Label &second) {
+      if (first.m_miles != second.m_miles)
+      {
+        return first.m_miles < second.m_miles;
+      }
+      return first.m_longest < second.m_longest;
+    });
+
+    frontier.clear();
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+      Label &label = candidates[i];
+      if (Dominated(label.m_airport, label.m_miles, label.m_longest))
+      {
+        continue;
+      }
+      m_bags[label.m_airport].push_back(m_labels.size());
+      if (label.m_airport != destination)
+      {
+        frontier.push_back(m_labels.size()); // arriving ends the itinerary
+      }
+      m_labels.push_back(label);
+    }
+  }
+
+  // Walk every kept label at the destination back to the origin
+  vector<ParetoPath> paths;
+  for (size_t i = 0; i < m_bags[destination].size(); i++)
+  {
+    int index = m_bags[destination][i];
+    if (index == 0)
+    {
+      continue; // origin and destination are the same airport
+    }
+    ParetoPath path;
+    path.m_miles = m_labels[index].m_miles;
+    path.m_legs = m_labels[index].m_legs;
+    path.m_longest = m_labels[index].m_longest;
+    for (int at = index; at != -1; at = m_labels[at].m_parent)
+    {
+      path.m_airports.push_back(m_labels[at].m_airport);
+    }
+    reverse(path.m_airports.begin(), path.m_airports.end());
+    paths.push_back(path);
+  }
+  sort(paths.begin(), paths.end(), [](const ParetoPath &first, const ParetoPath &second) {
+    if (first.m_legs != second.m_legs)
+    {
+      return first.m_legs < second.m_legs;
+    }
+    return first.m_miles < second.m_miles;
+  });
+  return paths;
+}
+
+// Name: TimedOut()
+// Desc: Returns whether the last Run stopped on its time budget
+// Preconditions: Run was called
+// Postconditions: Returns m_timedOut
+bool ParetoSearch::TimedOut()
+{
+  return m_timedOut;
+}
+
+// Name: Dominated(int, double, double)
+// Desc: Tells whether a label at an airport is beaten by one already
+//   kept there. Kept labels never have more legs than new ones
+// Preconditions: None
+// Postconditions: Returns true if some kept label is no worse on both
+bool ParetoSearch::Dominated(int airport, double miles, double longest)
+{
+  const vector<int> &bag = m_bags[airport];
+  for (size_t i = 0; i < bag.size(); i++)
+  {
+    const Label &kept = m_labels[bag[i]];
+    if (kept.m_miles <= miles && kept.m_longest <= longest)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Name: Extend(vector<int>&, int, int, int, vector<double>&, vector<Label>&)
+// Desc: Extends a slice of the frontier by one leg into candidates
+// Preconditions: Bags are not changed while this runs
+// Postconditions: Candidates that survive pruning are in found
+void ParetoSearch::Extend(const vector<int> &frontier, int first, int last, int destination,
+                          const vector<double> &toTarget, vector<Label> &found)
+{
+  for (int i = first; i < last; i++)
+  {
+    // Check the clock now and then, not on every label
+    if ((i - first) % 256 == 0 && chrono::steady_clock::now() > m_deadline)
+    {
+      m_timedOut = true;
+    }
+    if (m_timedOut)
+    {
+      return;
+    }
+
+    const Label &from = m_labels[frontier[i]];
+    bool lastLeg = from.m_legs + 1 == m_options.m_maxLegs;
+    for (const Leg *leg = m_graph->Begin(from.m_airport); leg != m_graph->End(from.m_airport); ++leg)
+    {
+      if (lastLeg && leg->m_to != destination)
+      {
+        continue; // no legs left to get to the destination
+      }
+      double legMiles = leg->m_miles;
+      double miles = from.m_miles + legMiles;
+      double longest = max(from.m_longest, legMiles);
+      if (Dominated(leg->m_to, miles, longest))
+      {
+        continue;
+      }
+      // Flying straight on from here is the best case, skip the label if
+      // an itinerary already found beats even that
+      if (leg->m_to != destination && Dominated(destination, miles + toTarget[leg->m_to], longest))
+      {
+        continue;
+      }
+
+      Label label;
+      label.m_airport = leg->m_to;
+      label.m_parent = frontier[i];
+      label.m_legs = from.m_legs + 1;
+      label.m_miles = miles;
+      label.m_longest = longest;
+      found.push_back(label);
+    }
+  }
+}
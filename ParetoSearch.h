@@ -0,0 +1,79 @@
+#ifndef PARETOSEARCH_H
+#define PARETOSEARCH_H
+
+#include "LegGraph.h"
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+using namespace std;
+
+// Limits for a Pareto search
+struct ParetoOptions {
+  double m_maxLeg;       //Longest leg the aircraft can fly (miles)
+  int m_maxLegs;         //Most legs in an itinerary
+  double m_budgetMillis; //Time budget, the frontier found so far is returned when it runs out
+  int m_threads;         //Worker threads for each round
+};
+
+// One itinerary on the Pareto frontier
+struct ParetoPath {
+  vector<int> m_airports; //Catalog indexes from origin to destination
+  double m_miles;         //Total miles
+  int m_legs;             //Number of legs (stops - 1)
+  double m_longest;       //Longest single leg
+};
+
+class ParetoSearch {
+ public:
+  // Name: ParetoSearch(LegGraph*, ParetoOptions)
+  // Desc: Prepares a search over a leg graph
+  // Preconditions: graph stays alive while the search runs
+  // Postconditions: Search is ready to run
+  ParetoSearch(LegGraph *graph, ParetoOptions options);
+  // Name: Run(int, int, vector<double>&)
+  // Desc: Label setting search, one round per leg. Each round extends the
+  //   labels of the last round in parallel, then keeps only labels that
+  //   no other label at the same airport beats on miles, legs and
+  //   longest leg. toTarget holds the direct miles from every airport
+  //   to the destination and prunes labels that cannot beat the frontier
+  // Preconditions: origin and destination are airports of the graph
+  // Postconditions: Returns the frontier sorted by legs, then miles.
+  //   m_timedOut tells whether the budget cut the search short
+  vector<ParetoPath> Run(int origin, int destination, const vector<double> &toTarget);
+  // Name: TimedOut()
+  // Desc: Returns whether the last Run stopped on its time budget
+  // Preconditions: Run was called
+  // Postconditions: Returns m_timedOut
+  bool TimedOut();
+ private:
+  struct Label {
+    int m_airport;    //Where the label is
+    int m_parent;     //Index of the label it extends (-1 at the origin)
+    int m_legs;       //Legs so far
+    double m_miles;   //Miles so far
+    double m_longest; //Longest leg so far
+  };
+
+  // Name: Dominated(int, double, double)
+  // Desc: Tells whether a label at an airport is beaten by one already
+  //   kept there. Kept labels never have more legs than new ones
+  // Preconditions: None
+  // Postconditions: Returns true if some kept label is no worse on both
+  bool Dominated(int airport, double miles, double longest);
+  // Name: Extend(vector<int>&, int, int, int, vector<double>&, vector<Label>&)
+  // Desc: Extends a slice of the frontier by one leg into candidates
+  // Preconditions: Bags are not changed while this runs
+  // Postconditions: Candidates that survive pruning are in found
+  void Extend(const vector<int> &frontier, int first, int last, int destination,
+              const vector<double> &toTarget, vector<Label> &found);
+
+  LegGraph *m_graph; //Legs between airports
+  ParetoOptions m_options; //Search limits
+  vector<Label> m_labels; //Every kept label, parents come first
+  vector<vector<int> > m_bags; //Kept label indexes per airport
+  chrono::steady_clock::time_point m_deadline; //When the time budget runs out
+  atomic<bool> m_timedOut; //Budget ran out during the last Run
+};
+
+#endif
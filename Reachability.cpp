@@ -0,0 +1,121 @@
+/*****************************************
+** File:    Reachability.cpp
+** Description: This file implements batched multi hop reachability over the leg graph with bitsets
+***********************************************/
+
+#include "Reachability.h"
+#include <algorithm>
+#include <thread>
+using namespace std;
+
+// Name: Reachability(LegGraph*, int)
+// Desc: Prepares reachability queries over a leg graph
+// Preconditions: graph stays alive while Run runs
+// Postconditions: Ready to run
+Reachability::Reachability(LegGraph *graph, int threads)
+    : m_graph(graph), m_threads(max(1, threads)), m_nextBatch(0)
+{
+}
+
+// Name: Run(vector<int>&, int, bool)
+// Desc: Breadth first search from every origin up to maxHops legs, 64
+//   origins at a time, batches shared out over the threads
+// Preconditions: Every origin is an airport of the graph
+// Postconditions: Returns one result per origin, in the same order.
+//   m_airports is filled only when listAirports is set
+vector<ReachResult> Reachability::Run(const vector<int> &origins, int maxHops, bool listAirports)
+{
+  vector<ReachResult> results(origins.size());
+  for (size_t i = 0; i < origins.size(); i++)
+  {
+    results[i].m_origin = origins[i];
+    results[i].m_counts.assign(max(0, maxHops), 0);
+  }
+  m_nextBatch = 0;
+  int batches = (origins.size() + REACH_BATCH - 1) / REACH_BATCH;
+  int threads = min(m_threads, max(1, batches)); // no thread without a batch to take
+  vector<thread> workers;
+  for (int t = 1; t < threads; t++)
+  {
+    workers.push_back(thread(&Reachability::Work, this, cref(origins), maxHops, listAirports, ref(results)));
+  }
+  Work(origins, maxHops, listAirports, results); // this thread works too
+  for (size_t t = 0; t < workers.size(); t++)
+  {
+    workers[t].join();
+  }
+  return results;
+}
+
+// Name: Work(vector<int>&, int, bool, vector<ReachResult>&)
+// Desc: Body of one thread. Takes batches until none are left
+// Preconditions: results has one entry per origin
+// Postconditions: results of the batches taken are filled
+void Reachability::Work(const vector<int> &origins, int maxHops, bool listAirports, vector<ReachResult> &results)
+{
+  int size = m_graph->GetSize();
+  vector<uint64_t> visited(size);
+  vector<uint64_t> frontier(size);
+  vector<uint64_t> next(size);
+
+  for (size_t first = m_nextBatch.fetch_add(REACH_BATCH); first < origins.size();
+       first = m_nextBatch.fetch_add(REACH_BATCH))
+  {
+    size_t count = min(origins.size() - first, static_cast<size_t>(REACH_BATCH));
+    fill(visited.begin(), visited.end(), 0);
+    fill(frontier.begin(), frontier.end(), 0);
+    for (size_t b = 0; b < count; b++)
+    {
+      uint64_t bit = uint64_t(1) << b;
+      visited[origins[first + b]] |= bit; // two origins may be the same airport
+      frontier[origins[first + b]] |= bit;
+    }
+
+    for (int hop = 0; hop < maxHops; hop++)
+    {
+      // Push every frontier word along its legs
+      fill(next.begin(), next.end(), 0);
+      bool moved = false;
+      for (int at = 0; at < size; at++)
+      {
+        uint64_t word = frontier[at];
+        if (word == 0)
+        {
+          continue;
+        }
+        for (const Leg *leg = m_graph->Begin(at); leg != m_graph->End(at); ++leg)
+        {
+          next[leg->m_to] |= word;
+        }
+      }
+
+      // Keep only what is new, then hand it to each origin of the batch
+      for (int at = 0; at < size; at++)
+      {
+        uint64_t word = next[at] & ~visited[at];
+        frontier[at] = word;
+        if (word == 0)
+        {
+          continue;
+        }
+        moved = true;
+        visited[at] |= word;
+        while (word != 0)
+        {
+          int b = __builtin_ctzll(word);
+          word &= word - 1;
+          ReachResult &result = results[first + b];
+          result.m_counts[hop]++;
+          if (listAirports)
+          {
+            result.m_airports.push_back(at);
+          }
+        }
+      }
+      if (!moved)
+      {
+        break; // every search of the batch has run out of airports
+      }
+    }
+  }
+}
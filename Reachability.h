@@ -0,0 +1,49 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include "LegGraph.h"
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+using namespace std;
+
+const int REACH_BATCH = 64; // Origins searched together, one bit of a word each
+
+// Airports reached from one origin
+struct ReachResult {
+  int m_origin;          //Catalog index of the origin
+  vector<int> m_counts;  //Airports first reached on hop 1, 2, ... (m_counts[0] is hop 1)
+  vector<int> m_airports; //Those airports in hop order, when asked for (m_counts slices it)
+};
+
+class Reachability {
+ public:
+  // Name: Reachability(LegGraph*, int)
+  // Desc: Prepares reachability queries over a leg graph
+  // Preconditions: graph stays alive while Run runs
+  // Postconditions: Ready to run
+  Reachability(LegGraph *graph, int threads);
+  // Name: Run(vector<int>&, int, bool)
+  // Desc: Breadth first search from every origin, hop by hop, up to
+  //   maxHops legs. Origins go in batches of REACH_BATCH: every airport
+  //   keeps one word for the batch's visited set and one for its
+  //   frontier, bit b standing for origin b, so a leg extends all 64
+  //   searches with one OR. Batches are shared out over the threads
+  // Preconditions: Every origin is an airport of the graph
+  // Postconditions: Returns one result per origin, in the same order.
+  //   m_airports is filled only when listAirports is set
+  vector<ReachResult> Run(const vector<int> &origins, int maxHops, bool listAirports);
+ private:
+  // Name: Work(vector<int>&, int, bool, vector<ReachResult>&)
+  // Desc: Body of one thread. Takes batches until none are left
+  // Preconditions: results has one entry per origin
+  // Postconditions: results of the batches taken are filled
+  void Work(const vector<int> &origins, int maxHops, bool listAirports, vector<ReachResult> &results);
+
+  LegGraph *m_graph; //Graph being searched
+  int m_threads; //Worker threads
+  atomic<size_t> m_nextBatch; //First origin of the next batch to hand out
+};
+
+#endif
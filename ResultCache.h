@@ -0,0 +1,259 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "Memory.h"
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+using namespace std;
+
+const int CACHE_SHARDS = 16; // Independent locks, so threads rarely wait on each other
+const size_t CACHE_DEFAULT_BYTES = 8 * 1024 * 1024; // Budget of a cache unless told otherwise
+
+// A query between two airports (stable catalog ids) with its parameters
+struct CacheKey {
+  int m_from;       //Airport id
+  int m_to;         //Airport id
+  string m_params;  //Everything else that changes the answer, as text
+
+  bool operator==(const CacheKey &other) const
+  {
+    return m_from == other.m_from && m_to == other.m_to && m_params == other.m_params;
+  }
+};
+
+struct CacheKeyHash {
+  size_t operator()(const CacheKey &key) const
+  {
+    size_t seed = hash<int>()(key.m_from) * 1000003u ^ hash<int>()(key.m_to);
+    return seed * 1000003u ^ hash<string>()(key.m_params);
+  }
+};
+
+// A query between two airports with no other parameters, packed into
+// one word (see PairKey) so the key needs no heap and hashes quickly
+typedef uint64_t PairKey;
+
+// Name: MakePairKey(int, int)
+// Desc: Packs two airport ids into a PairKey
+// Preconditions: Ids are not negative
+// Postconditions: Returns the key, different for every ordered pair
+inline PairKey MakePairKey(int from, int to)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(from)) << 32) | static_cast<uint32_t>(to);
+}
+
+struct PairKeyHash {
+  size_t operator()(PairKey key) const
+  {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 16); // mixes both ids into the low bits
+  }
+};
+
+// Counters of a cache since it was built
+struct CacheStats {
+  long m_hits;          //Gets that found an answer
+  long m_misses;        //Gets that did not
+  long m_evictions;     //Entries dropped to stay in budget
+  long m_invalidations; //Shards emptied because the catalog changed
+  long m_entries;       //Entries held now
+  size_t m_bytes;       //Bytes held now (as charged by Put)
+  size_t m_capacity;    //Byte budget
+};
+
+template <class Value, class Key = CacheKey, class KeyHash = CacheKeyHash>
+class ResultCache {
+ public:
+  // Name: ResultCache(size_t) - Overloaded Constructor
+  // Desc: Builds an empty cache with a byte budget, split evenly over
+  //   CACHE_SHARDS shards that each keep their own least recently used order
+  // Preconditions: None
+  // Postconditions: Cache is empty
+  ResultCache(size_t capacityBytes = CACHE_DEFAULT_BYTES)
+      : m_capacity(capacityBytes), m_hits(0), m_misses(0), m_evictions(0), m_invalidations(0)
+  {
+  }
+  // Name: Get(Key&, unsigned long, Value&)
+  // Desc: Looks up an answer computed on a catalog generation. A newer
+  //   generation empties the shard first (the catalog changed), an
+  //   older one (a reader on an old snapshot) just misses
+  // Preconditions: None
+  // Postconditions: Returns true and fills value on a hit, which also
+  //   makes the entry the most recently used
+  bool Get(const Key &key, unsigned long generation, Value &value)
+  {
+    Shard &shard = ShardFor(key);
+    lock_guard<mutex> hold(shard.m_lock);
+    if (generation > shard.m_generation)
+    {
+      Reset(shard, generation);
+    }
+    auto found = shard.m_find.end();
+    if (generation == shard.m_generation)
+    {
+      found = shard.m_find.find(key);
+    }
+    if (found == shard.m_find.end())
+    {
+      m_misses++;
+      return false;
+    }
+    shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, found->second);
+    value = found->second->m_value;
+    m_hits++;
+    return true;
+  }
+  // Name: Put(Key&, unsigned long, Value&, size_t)
+  // Desc: Stores an answer computed on a catalog generation, charged at
+  //   bytes (heap the value owns) plus ENTRY_OVERHEAD. Least recently used entries of
+  //   the shard are evicted until it fits its share of the budget
+  // Preconditions: None
+  // Postconditions: The answer is cached unless it is from an older
+  //   generation or larger than a shard's share
+  void Put(const Key &key, unsigned long generation, const Value &value, size_t bytes)
+  {
+    bytes += ENTRY_OVERHEAD;
+    Shard &shard = ShardFor(key);
+    lock_guard<mutex> hold(shard.m_lock);
+    if (generation > shard.m_generation)
+    {
+      Reset(shard, generation);
+    }
+    if (generation < shard.m_generation || bytes > m_capacity / CACHE_SHARDS)
+    {
+      return;
+    }
+    auto found = shard.m_find.find(key);
+    if (found != shard.m_find.end())
+    {
+      shard.m_bytes -= found->second->m_bytes;
+      shard.m_entries.erase(found->second);
+      shard.m_find.erase(found);
+    }
+    Entry entry;
+    entry.m_key = key;
+    entry.m_value = value;
+    entry.m_bytes = bytes;
+    shard.m_entries.push_front(entry);
+    shard.m_find[key] = shard.m_entries.begin();
+    shard.m_bytes += bytes;
+    Trim(shard);
+  }
+  // Name: SetCapacity(size_t)
+  // Desc: Changes the byte budget, evicting what no longer fits
+  // Preconditions: None
+  // Postconditions: Every shard is within its share of the budget
+  void SetCapacity(size_t bytes)
+  {
+    m_capacity = bytes;
+    for (int i = 0; i < CACHE_SHARDS; i++)
+    {
+      lock_guard<mutex> hold(m_shards[i].m_lock);
+      Trim(m_shards[i]);
+    }
+  }
+  // Name: GetStats()
+  // Desc: Returns the counters and current size
+  // Preconditions: None
+  // Postconditions: Returns a CacheStats
+  CacheStats GetStats()
+  {
+    CacheStats stats;
+    stats.m_hits = m_hits;
+    stats.m_misses = m_misses;
+    stats.m_evictions = m_evictions;
+    stats.m_invalidations = m_invalidations;
+    stats.m_entries = 0;
+    stats.m_bytes = 0;
+    stats.m_capacity = m_capacity;
+    for (int i = 0; i < CACHE_SHARDS; i++)
+    {
+      lock_guard<mutex> hold(m_shards[i].m_lock);
+      stats.m_entries += m_shards[i].m_entries.size();
+      stats.m_bytes += m_shards[i].m_bytes;
+    }
+    return stats;
+  }
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the cache in a memory report, as charged by Put
+  // Preconditions: None
+  // Postconditions: usage includes the bytes, one block per entry
+  void AddMemory(MemoryUsage &usage)
+  {
+    CacheStats stats = GetStats();
+    usage.m_bytes += stats.m_bytes;
+    usage.m_allocations += stats.m_entries;
+  }
+ private:
+  struct Entry {
+    Key m_key;       //Key, kept to erase the map entry on eviction
+    Value m_value;   //Cached answer
+    size_t m_bytes;  //Bytes charged for the entry
+  };
+  struct Shard {
+    Shard() : m_bytes(0), m_generation(0) {}
+    mutex m_lock; //Guards everything below
+    list<Entry> m_entries; //Most recently used first
+    unordered_map<Key, typename list<Entry>::iterator, KeyHash> m_find; //Key to its entry
+    size_t m_bytes; //Bytes charged for the entries
+    unsigned long m_generation; //Catalog generation of the entries
+  };
+
+  // Name: ShardFor(Key&)
+  // Desc: Picks the shard of a key
+  // Preconditions: None
+  // Postconditions: Returns one of m_shards
+  Shard &ShardFor(const Key &key)
+  {
+    return m_shards[(KeyHash()(key) >> 4) % CACHE_SHARDS];
+  }
+  // Name: Reset(Shard&, unsigned long)
+  // Desc: Empties a shard for a newer catalog generation
+  // Preconditions: The shard is locked
+  // Postconditions: Shard is empty and on generation
+  void Reset(Shard &shard, unsigned long generation)
+  {
+    if (!shard.m_entries.empty())
+    {
+      m_invalidations++;
+    }
+    shard.m_entries.clear();
+    shard.m_find.clear();
+    shard.m_bytes = 0;
+    shard.m_generation = generation;
+  }
+  // Name: Trim(Shard&)
+  // Desc: Evicts least recently used entries past the shard's share
+  // Preconditions: The shard is locked
+  // Postconditions: Shard is within its share of the budget
+  void Trim(Shard &shard)
+  {
+    while (!shard.m_entries.empty() && shard.m_bytes > m_capacity / CACHE_SHARDS)
+    {
+      Entry &oldest = shard.m_entries.back();
+      shard.m_bytes -= oldest.m_bytes;
+      shard.m_find.erase(oldest.m_key);
+      shard.m_entries.pop_back();
+      m_evictions++;
+    }
+  }
+
+  // List node (two links and the entry) and hash node (link, cached
+  // hash, key and list position) of one entry
+  static const size_t ENTRY_OVERHEAD = 2 * sizeof(void *) + sizeof(Entry) + sizeof(void *) + sizeof(size_t) +
+                                       sizeof(Key) + sizeof(typename list<Entry>::iterator);
+
+  Shard m_shards[CACHE_SHARDS]; //Independent parts of the cache
+  atomic<size_t> m_capacity; //Byte budget of the whole cache
+  atomic<long> m_hits;
+  atomic<long> m_misses;
+  atomic<long> m_evictions;
+  atomic<long> m_invalidations;
+};
+
+#endif
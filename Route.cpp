@@ -7,11 +7,17 @@
 using namespace std;
 
 // Name: Route() - Default Constructor
-// Desc: Used to build a new Route (linked list) make up of airports
+// Desc: Used to build a new Route made up of airports. The first
+//   ROUTE_INLINE stops are stored inside the Route, longer routes move
+//   to one heap array
 // Preconditions: None
-// Postconditions: Creates a new Route where m_head and m_tail
-//   point to nullptr and size = 0
-Route::Route() : m_head(nullptr), m_tail(nullptr), m_size(0) {}
+// Postconditions: Creates a new empty Route (size = 0) using the
+//   inline stops
+Route::Route()
+    : m_autoName(false), m_nameFrom(SYMBOL_EMPTY), m_nameTo(SYMBOL_EMPTY), m_stops(m_inline), m_size(0),
+      m_capacity(ROUTE_INLINE), m_miles(0.0), m_index(nullptr)
+{
+}
 
 // Name: SetName(string)
 // Desc: Sets the name of the route (usually first
@@ -21,50 +27,74 @@ Route::Route() : m_head(nullptr), m_tail(nullptr), m_size(0) {}
 void Route::SetName(string name)
 {
   m_name = name;
+  m_autoName = false;
 }
 
 // Name: ~Route() - Destructor
 // Desc: Used to destruct a strand of Route
 // Preconditions: There is an existing Route strand with at least
 //   one airport
-// Postconditions: Route is deallocated (including all
-//   dynamically allocated airports) to have no memory leaks!
+// Postconditions: Route is deallocated (including the heap array
+//   of a long route) to have no memory leaks!
 Route::~Route()
 {
-  Airport *current = m_head; // head of the linked list
-  while (current != nullptr)
+  if (m_index != nullptr)
   {
-    Airport *next = current->GetNext(); // getting next node
-    delete current;                     // delete current node
-    current = next;
+    for (int i = 0; i < m_size; i++)
+    {
+      m_index->RemoveStop(m_stops[i].GetId(), this); // route is going away
+    }
+    m_index->Drop(this);
   }
-  m_head = nullptr;
-  m_tail = nullptr;
+  if (m_stops != m_inline)
+  {
+    delete[] m_stops;
+  }
+  m_stops = m_inline;
   m_size = 0;
 }
 
-// Name: InsertEnd (string, string, double double)
+// Name: InsertEnd (string, string, double double, int)
 // Desc: Creates a new airport using the data passed to it.
 //   Inserts the new airport at the end of the route
+//   The optional id is the stable catalog id of the airport
 // Preconditions: Takes in a Airport
 // Requires a Route
 // Postconditions: Adds the new airport to the end of a route
-void Route::InsertEnd(string code, string name, string city, string country, double north, double west)
+void Route::InsertEnd(string code, string name, string city, string country, double north, double west, int id)
+{
+  Airport airport(code, name, city, country, north, west);
+  airport.SetId(id); // keep the catalog id so the stop can be matched after a reload
+  InsertEnd(airport);
+}
+
+// Name: InsertEnd (Airport&)
+// Desc: Inserts a copy of an airport (catalog id and interned text
+//   included, so nothing is looked up again) at the end of the route.
+//   airport may be one of this route's own stops (GetData)
+// Preconditions: Requires a Route
+// Postconditions: Adds the new airport to the end of a route
+void Route::InsertEnd(Airport &airport)
 {
-  Airport *newAirport = new Airport(code, name, city, country, north, west);
-  newAirport->SetNext(nullptr);
+  Airport copy = airport; // Reserve may move the stops airport is one of
+  Reserve(m_size + 1);
+  Airport &newAirport = m_stops[m_size];
+  newAirport = copy;
+  newAirport.SetNext(nullptr);
 
-  if (m_head == nullptr) // check if the list is empty
+  if (m_size > 0)
   {
-    m_head = m_tail = newAirport; // list is empty, newAirport is both the head and tail
+    // Attach the newAirport to the end of the route
+    Airport &tail = m_stops[m_size - 1];
+    m_miles += DefaultDistance::Miles(tail.GetNorth(), tail.GetWest(), newAirport.GetNorth(), newAirport.GetWest());
+    tail.SetNext(&newAirport);
   }
-  else
+  m_size++;
+
+  if (m_index != nullptr)
   {
-    // If the list is not empty, attach the newAirport to the end of the list and update the tail.
-    m_tail->SetNext(newAirport);
-    m_tail = newAirport;
+    m_index->AddStop(newAirport.GetId(), this);
   }
-  m_size++;
 }
 
 // Name: RemoveAirport(int index)
@@ -83,55 +113,62 @@ void Route::RemoveAirport(int index)
     cout << "Invalid index." << endl;
     return;
   }
-
-  Airport *current = m_head;
-  Airport *prev = nullptr; // initialize previous pointer to null
-  for (int i = 0; i < index; ++i)
-  {
-    prev = current; // keep track of the previous node
-    current = current->GetNext();
-  }
-  // case where node to be removed is the first node
-  if (prev == nullptr)
+  if (m_index != nullptr)
   {
-    m_head = current->GetNext();
+    m_index->RemoveStop(m_stops[index].GetId(), this);
   }
-  else
+  // Close the gap; the stops after it move down one
+  for (int i = index; i + 1 < m_size; i++)
   {
-    // For nodes in the middle or the end, bypass the current node by linking prev to current's next
-    prev->SetNext(current->GetNext());
+    m_stops[i] = m_stops[i + 1];
   }
-  // case where node to be removed is the last node
-  if (current == m_tail)
-  {
-    m_tail = prev;
-  }
-  delete current; // Free the memory occupied by the node being removed
-
   m_size--;
+  Refresh(false);
 }
 
 // Name: GetName()
 // Desc: Returns the name of the route (Usually starting airport to last airport For example: Baltimore to Boston
 // Preconditions: Requires a Route
-// Postconditions: Returns m_name;
+// Postconditions: Returns m_name, or the city name built from
+//   m_nameFrom and m_nameTo
 string Route::GetName()
 {
+  if (m_autoName)
+  {
+    return SymbolTable::Shared().Text(m_nameFrom) + " to " + SymbolTable::Shared().Text(m_nameTo);
+  }
   return m_name;
 }
 
+// Name: NameByCities()
+// Desc: Names the route first city to last city. Only the two
+//   interned cities are kept, the text is built by GetName
+// Preconditions: None
+// Postconditions: Name follows the current end cities (unchanged
+//   for an empty route)
+void Route::NameByCities()
+{
+  if (m_size > 0)
+  {
+    m_nameFrom = m_stops[0].GetCityId();
+    m_nameTo = m_stops[m_size - 1].GetCityId();
+    m_autoName = true;
+  }
+}
+
 // Name: UpdateName()
 // Desc: Updates m_name based on the name of the first airport in the route and the last airport in the route For example: Baltimore to Boston
 // Preconditions: Requires a Route with at least two airports
 // Postconditions: Returns m_name;
 string Route::UpdateName()
 {
-  if (m_head != nullptr && m_tail != nullptr)
+  if (m_size > 0)
   {
     // route's name is first airport to last airport
-    m_name = m_head->GetName() + " to " + m_tail->GetName();
+    m_name = m_stops[0].GetName() + " to " + m_stops[m_size - 1].GetName();
+    m_autoName = false;
   }
-  return m_name;
+  return GetName();
 }
 
 // Name: GetSize()
@@ -143,45 +180,289 @@ int Route::GetSize()
   return m_size;
 }
 
+// Name: GetMiles()
+// Desc: Returns the total miles of the route, kept current by every
+//   edit (DefaultDistance, see DistanceModel.h)
+// Preconditions: None
+// Postconditions: Returns m_miles (0 for fewer than two airports)
+double Route::GetMiles()
+{
+  return m_miles;
+}
+
 // Name: ReverseRoute
 // Desc: Reverses a route
 // Preconditions: Reverses the Route
 // Postconditions: Route is reversed in place; nothing returned
 void Route::ReverseRoute()
 {
-  Airport *prev = nullptr;
-  Airport *current = m_head;
-  Airport *next = nullptr;
-  m_tail = m_head; // After reversal, head becomes tail
-
-  while (current != nullptr)
+  for (int first = 0, last = m_size - 1; first < last; first++, last--)
   {
-    next = current->GetNext(); // Store next node
-    current->SetNext(prev);    // Reverse current node's pointer
-    prev = current;            // Move pointers one position ahead
-    current = next;
+    swap(m_stops[first], m_stops[last]); // links are redone by Refresh
+  }
+  Refresh(false);
+  if (m_index != nullptr)
+  {
+    m_index->Touch(this); // same stops, new order
   }
-  m_head = prev; // After reversal, prev will be new head
 }
 
 // Name: GetData (int)
-// Desc: Returns an airport at a specific index
+// Desc: Returns an airport at a specific index (constant time)
 // Preconditions: Requires a Route
-// Postconditions: Returns the airport from specific item
+// Postconditions: Returns the airport from specific item, valid
+//   until the route is next edited
 Airport *Route::GetData(int index)
 {
   if (index < 0 || index >= m_size)
   {
     return nullptr; // If the index is out of bounds, return nullptr to indicate an invalid request.
   }
+  return &m_stops[index];
+}
+
+// Name: SetIndex(RouteIndex*)
+// Desc: Registers the route with an airport to route index. Every
+//   later InsertEnd, RemoveAirport and the destructor keep it current
+// Preconditions: index outlives the route (or is replaced first)
+// Postconditions: All current stops are moved from the old index
+//   (if any) to the new one
+void Route::SetIndex(RouteIndex *index)
+{
+  for (int i = 0; i < m_size; i++)
+  {
+    if (m_index != nullptr)
+    {
+      m_index->RemoveStop(m_stops[i].GetId(), this);
+    }
+    if (index != nullptr)
+    {
+      index->AddStop(m_stops[i].GetId(), this);
+    }
+  }
+  m_index = index;
+}
+
+// Name: RemoveAirports(vector<int>&)
+// Desc: Removes the airports at several indexes in one pass. Indexes
+//   may come in any order; repeats and ones out of range are ignored
+// Preconditions: None
+// Postconditions: Returns how many airports were removed. Name and
+//   miles are updated once
+int Route::RemoveAirports(const vector<int> &indexes)
+{
+  vector<bool> doomed(m_size, false);
+  for (size_t i = 0; i < indexes.size(); i++)
+  {
+    if (indexes[i] >= 0 && indexes[i] < m_size)
+    {
+      doomed[indexes[i]] = true;
+    }
+  }
 
-  Airport *temp = m_head; // Start from the head of the list.
+  // Keep the survivors in order, overwriting the doomed stops
+  int kept = 0;
+  for (int i = 0; i < m_size; i++)
+  {
+    if (doomed[i])
+    {
+      if (m_index != nullptr)
+      {
+        m_index->RemoveStop(m_stops[i].GetId(), this);
+      }
+    }
+    else
+    {
+      if (kept != i)
+      {
+        m_stops[kept] = m_stops[i];
+      }
+      kept++;
+    }
+  }
+  int removed = m_size - kept;
+  m_size = kept;
+  if (removed > 0)
+  {
+    Refresh(true);
+  }
+  return removed;
+}
 
-  for (int i = 0; i < index; i++)
+// Name: RemoveCode(string)
+// Desc: Removes every stop at the airport with a code in one pass
+// Preconditions: None
+// Postconditions: Returns how many airports were removed. Name and
+//   miles are updated once
+int Route::RemoveCode(string code)
+{
+  vector<int> indexes;
+  for (int i = 0; i < m_size; i++)
+  {
+    if (m_stops[i].GetCode() == code)
+    {
+      indexes.push_back(i);
+    }
+  }
+  return RemoveAirports(indexes);
+}
+
+// Name: Splice(int, Route&)
+// Desc: Moves every airport of other into this route before index
+//   (index GetSize() appends), shifting the later stops once
+// Preconditions: other is not this route
+// Postconditions: other is empty. Name and miles of both are updated
+//   once and the stops are moved between their indexes
+void Route::Splice(int index, Route &other)
+{
+  if (&other == this || other.m_size == 0)
+  {
+    return;
+  }
+  if (index < 0 || index > m_size)
+  {
+    cout << "Invalid index." << endl;
+    return;
+  }
+
+  // The stops change routes, so they change entries in the index too
+  for (int i = 0; i < other.m_size; i++)
+  {
+    if (other.m_index != nullptr)
+    {
+      other.m_index->RemoveStop(other.m_stops[i].GetId(), &other);
+    }
+    if (m_index != nullptr)
+    {
+      m_index->AddStop(other.m_stops[i].GetId(), this);
+    }
+  }
+
+  int count = other.m_size;
+  Reserve(m_size + count);
+  for (int i = m_size - 1; i >= index; i--)
+  {
+    m_stops[i + count] = m_stops[i]; // open the gap from the end
+  }
+  for (int i = 0; i < count; i++)
+  {
+    m_stops[index + i] = other.m_stops[i];
+  }
+  m_size += count;
+
+  other.m_size = 0;
+  other.Refresh(false);
+  Refresh(true);
+}
+
+// Name: Concatenate(Route&)
+// Desc: Moves every airport of other onto the end of this route
+// Preconditions: other is not this route
+// Postconditions: Same as Splice(GetSize(), other)
+void Route::Concatenate(Route &other)
+{
+  Splice(m_size, other);
+}
+
+// Name: Split(int)
+// Desc: Moves the airports from index to the end into a new route
+// Preconditions: index is in [0, GetSize()]
+// Postconditions: Returns the new route on the same index, the caller
+//   owns it. Name and miles of both are updated once
+Route *Route::Split(int index)
+{
+  Route *rest = new Route();
+  if (index < 0 || index >= m_size)
+  {
+    return rest; // nothing past the end to move
+  }
+
+  rest->Reserve(m_size - index);
+  for (int i = index; i < m_size; i++)
+  {
+    rest->m_stops[rest->m_size++] = m_stops[i];
+    if (m_index != nullptr)
+    {
+      m_index->RemoveStop(m_stops[i].GetId(), this);
+      m_index->AddStop(m_stops[i].GetId(), rest);
+    }
+  }
+  m_size = index;
+  rest->m_index = m_index;
+  rest->Refresh(true);
+  Refresh(true);
+  return rest;
+}
+
+// Name: Reserve(int)
+// Desc: Makes room for count stops, moving to a heap array (at least
+//   doubled) once the inline stops are not enough
+// Preconditions: None
+// Postconditions: m_capacity >= count, stops and links are kept
+void Route::Reserve(int count)
+{
+  if (count <= m_capacity)
+  {
+    return;
+  }
+  int capacity = max(count, m_capacity * 2);
+  Airport *stops = new Airport[capacity];
+  for (int i = 0; i < m_size; i++)
+  {
+    stops[i] = m_stops[i];
+  }
+  if (m_stops != m_inline)
+  {
+    delete[] m_stops;
+  }
+  m_stops = stops;
+  m_capacity = capacity;
+  for (int i = 0; i < m_size; i++)
+  {
+    m_stops[i].SetNext(i + 1 < m_size ? &m_stops[i + 1] : nullptr); // the old links pointed into the old array
+  }
+}
+
+// Name: Refresh(bool)
+// Desc: Links the stops in order and sets m_miles, and when rename is
+//   true names the route first city to last city
+// Preconditions: m_stops holds m_size stops
+// Postconditions: Links and cached fields match the airports
+void Route::Refresh(bool rename)
+{
+  m_miles = 0.0;
+  for (int i = 0; i < m_size; i++)
+  {
+    Airport *next = (i + 1 < m_size) ? &m_stops[i + 1] : nullptr;
+    m_stops[i].SetNext(next);
+    if (next != nullptr)
+    {
+      m_miles += DefaultDistance::Miles(m_stops[i].GetNorth(), m_stops[i].GetWest(), next->GetNorth(), next->GetWest());
+    }
+  }
+  if (rename)
+  {
+    NameByCities();
+  }
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the heap held by the route: its name and the stop array
+//   of a long route. The Route object itself (inline stops included)
+//   is counted by whoever allocated it
+// Preconditions: None
+// Postconditions: usage includes the route's heap
+void Route::AddMemory(MemoryUsage &usage)
+{
+  AddString(usage, m_name);
+  if (m_stops != m_inline)
+  {
+    AddBlock(usage, m_capacity * sizeof(Airport));
+  }
+  for (int i = 0; i < m_size; i++)
   {
-    temp = temp->GetNext();
+    m_stops[i].AddMemory(usage);
   }
-  return temp;
 }
 
 // Name: DisplayRoute
@@ -193,7 +474,7 @@ void Route::DisplayRoute()
 {
   int counter = 1; // Initialize a counter to number each Airport in the output.
 
-  Airport *current = m_head;
+  Airport *current = GetData(0);
 
   while (current != nullptr)
   {
@@ -7,15 +7,22 @@
 #include <cmath>
 
 #include "Airport.h"
+#include "RouteIndex.h"
+#include "DistanceModel.h"
+#include <vector>
 using namespace std;
 
+const int ROUTE_INLINE = 6; // Stops kept inside the Route itself before spilling to the heap
+
 class Route {
  public:
   // Name: Route() - Default Constructor
-  // Desc: Used to build a new Route (linked list) make up of airports
+  // Desc: Used to build a new Route made up of airports. The first
+  //   ROUTE_INLINE stops are stored inside the Route, longer routes move
+  //   to one heap array. Stops stay linked through GetNext in order
   // Preconditions: None
-  // Postconditions: Creates a new Route where m_head and m_tail
-  //   point to nullptr and size = 0
+  // Postconditions: Creates a new empty Route (size = 0) using the
+  //   inline stops
   Route();
   // Name: SetName(string)
   // Desc: Sets the name of the route (usually first
@@ -27,16 +34,25 @@ class Route {
   // Desc: Used to destruct a strand of Route
   // Preconditions: There is an existing Route strand with at least
   //   one airport
-  // Postconditions: Route is deallocated (including all
-  //   dynamically allocated airports) to have no memory leaks!
+  // Postconditions: Route is deallocated (including the heap array
+  //   of a long route) to have no memory leaks!
  ~Route();
-  // Name: InsertEnd (string, string, double double)
+  // Name: InsertEnd (string, string, double double, int)
   // Desc: Creates a new airport using the data passed to it.
   //   Inserts the new airport at the end of the route
+  //   The optional id is the stable catalog id of the airport
   // Preconditions: Takes in a Airport
   //                Requires a Route
+  // Postconditions: Adds the new airport to the end of a route.
+  //   Airport pointers from GetData may move when the route grows
+  void InsertEnd(string, string, string, string, double, double, int id = -1);
+  // Name: InsertEnd (Airport&)
+  // Desc: Inserts a copy of an airport (catalog id and interned text
+  //   included, so nothing is looked up again) at the end of the route.
+  //   airport may be one of this route's own stops (GetData)
+  // Preconditions: Requires a Route
   // Postconditions: Adds the new airport to the end of a route
-  void InsertEnd(string, string, string, string, double, double);
+  void InsertEnd(Airport &airport);
   // Name: RemoveAirport(int index)
   // Desc: Removes a airport from the route at the index provided
   //   Hint: Special cases (first airport, last airport, middle airport)
@@ -51,8 +67,17 @@ class Route {
   //  airport to last airport)
   //  For example: Baltimore to Boston
   // Preconditions: Requires a Route
-  // Postconditions: Returns m_name;
+  // Postconditions: Returns m_name, or the city name built from
+  //   m_nameFrom and m_nameTo
   string GetName();
+  // Name: NameByCities()
+  // Desc: Names the route first city to last city. Only the two
+  //   interned cities are kept, the text is built by GetName, so naming
+  //   allocates nothing
+  // Preconditions: None
+  // Postconditions: Name follows the current end cities (unchanged
+  //   for an empty route)
+  void NameByCities();
   // Name: UpdateName()
   // Desc: Updates m_name based on the name of the first airport
   //   in the route and the last airport in the route
@@ -65,16 +90,68 @@ class Route {
   // Preconditions: Requires a Route
   // Postconditions: Returns m_size;
   int GetSize();
+  // Name: GetMiles()
+  // Desc: Returns the total miles of the route, kept current by every
+  //   edit (DefaultDistance, see DistanceModel.h)
+  // Preconditions: None
+  // Postconditions: Returns m_miles (0 for fewer than two airports)
+  double GetMiles();
   // Name: ReverseRoute
   // Desc: Reverses a route
   // Preconditions: Reverses the Route
   // Postconditions: Route is reversed in place; nothing returned
   void ReverseRoute();
   // Name: GetData (int)
-  // Desc: Returns an airport at a specific index
+  // Desc: Returns an airport at a specific index (constant time)
   // Preconditions: Requires a Route
-  // Postconditions: Returns the airport from specific item
+  // Postconditions: Returns the airport from specific item, valid
+  //   until the route is next edited
   Airport* GetData(int index);
+  // Name: SetIndex(RouteIndex*)
+  // Desc: Registers the route with an airport to route index. Every
+  //   later InsertEnd, RemoveAirport and the destructor keep it current
+  // Preconditions: index outlives the route (or is replaced first)
+  // Postconditions: All current stops are moved from the old index
+  //   (if any) to the new one
+  void SetIndex(RouteIndex *index);
+  // Name: RemoveAirports(vector<int>&)
+  // Desc: Removes the airports at several indexes in one pass. Indexes
+  //   may come in any order; repeats and ones out of range are ignored
+  // Preconditions: None
+  // Postconditions: Returns how many airports were removed. Name and
+  //   miles are updated once
+  int RemoveAirports(const vector<int> &indexes);
+  // Name: RemoveCode(string)
+  // Desc: Removes every stop at the airport with a code in one pass
+  // Preconditions: None
+  // Postconditions: Returns how many airports were removed. Name and
+  //   miles are updated once
+  int RemoveCode(string code);
+  // Name: Splice(int, Route&)
+  // Desc: Moves every airport of other into this route before index
+  //   (index GetSize() appends), shifting the later stops once
+  // Preconditions: other is not this route
+  // Postconditions: other is empty. Name and miles of both are updated
+  //   once and the stops are moved between their indexes
+  void Splice(int index, Route &other);
+  // Name: Concatenate(Route&)
+  // Desc: Moves every airport of other onto the end of this route
+  // Preconditions: other is not this route
+  // Postconditions: Same as Splice(GetSize(), other)
+  void Concatenate(Route &other);
+  // Name: Split(int)
+  // Desc: Moves the airports from index to the end into a new route
+  // Preconditions: index is in [0, GetSize()]
+  // Postconditions: Returns the new route on the same index, the caller
+  //   owns it. Name and miles of both are updated once
+  Route* Split(int index);
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the heap held by the route: its name and the stop array
+  //   of a long route. The Route object itself (inline stops included)
+  //   is counted by whoever allocated it
+  // Preconditions: None
+  // Postconditions: usage includes the route's heap
+  void AddMemory(MemoryUsage &usage);
   // Name: DisplayRoute
   // Desc: Displays all of the airports in a route
   // Preconditions: Requires a Route
@@ -82,10 +159,32 @@ class Route {
   // Formatted: Baltimore, Maryland (N39.209 W76.517)
   void DisplayRoute();
  private:
-  string m_name; //Name of the Route
-  Airport *m_head; //Front of the Route (Starting Point)
-  Airport *m_tail; //End of the Route (Ending Point)
+  // Name: Reserve(int)
+  // Desc: Makes room for count stops, moving to a heap array (at least
+  //   doubled) once the inline stops are not enough
+  // Preconditions: None
+  // Postconditions: m_capacity >= count, stops and links are kept
+  void Reserve(int count);
+  // Name: Refresh(bool)
+  // Desc: Links the stops in order and sets m_miles, and when rename is
+  //   true names the route first city to last city
+  // Preconditions: m_stops holds m_size stops
+  // Postconditions: Links and cached fields match the airports
+  void Refresh(bool rename);
+
+  Route(const Route &) = delete; // stops link into this object
+  Route &operator=(const Route &) = delete;
+
+  string m_name; //Name of the Route (when m_autoName is false)
+  bool m_autoName; //Name is m_nameFrom to m_nameTo
+  Symbol m_nameFrom; //City of the first stop when the route was named
+  Symbol m_nameTo; //City of the last stop when the route was named
+  Airport m_inline[ROUTE_INLINE]; //Stops of a short route, no heap needed
+  Airport *m_stops; //m_inline, or the heap array of a long route
   int m_size; //Total size of the Route
+  int m_capacity; //Stops m_stops can hold
+  double m_miles; //Total miles, updated by every edit
+  RouteIndex *m_index; //Airport to route index kept up to date (may be nullptr)
 };
 
 #endif
@@ -0,0 +1,133 @@
+/*****************************************
+** File:    RouteIndex.cpp
+** Description: This file implements the index from airports to the stored routes that stop at them
+***********************************************/
+
+#include "RouteIndex.h"
+using namespace std;
+
+// Name: RouteIndex() - Default Constructor
+// Desc: Builds an empty airport to route index
+// Preconditions: None
+// Postconditions: No routes are indexed
+RouteIndex::RouteIndex()
+{
+}
+
+// Name: AddStop(int, Route*)
+// Desc: Records that a route stops at an airport. A route can stop at
+//   the same airport more than once, each stop is counted
+// Preconditions: id is a stable catalog id (ignored if negative)
+// Postconditions: route is listed under id
+void RouteIndex::AddStop(int id, Route *route)
+{
+  m_changed.insert(route);
+  if (id < 0)
+  {
+    return; // airport was never cataloged, nothing to look it up by
+  }
+  m_stops[id][route]++;
+}
+
+// Name: RemoveStop(int, Route*)
+// Desc: Forgets one stop of a route at an airport
+// Preconditions: The stop was added with AddStop
+// Postconditions: route is no longer listed under id once its last
+//   stop there is removed
+void RouteIndex::RemoveStop(int id, Route *route)
+{
+  m_changed.insert(route);
+  auto airport = m_stops.find(id);
+  if (airport == m_stops.end())
+  {
+    return;
+  }
+  auto entry = airport->second.find(route);
+  if (entry == airport->second.end())
+  {
+    return;
+  }
+  if (--entry->second == 0)
+  {
+    airport->second.erase(entry);
+    if (airport->second.empty())
+    {
+      m_stops.erase(airport); // keep the map sized to airports in use
+    }
+  }
+}
+
+// Name: RoutesAt(int)
+// Desc: Returns every route that stops at an airport
+// Preconditions: None
+// Postconditions: Returns the routes in no particular order
+vector<Route *> RouteIndex::RoutesAt(int id)
+{
+  vector<Route *> routes;
+  auto airport = m_stops.find(id);
+  if (airport != m_stops.end())
+  {
+    routes.reserve(airport->second.size());
+    for (auto entry = airport->second.begin(); entry != airport->second.end(); ++entry)
+    {
+      routes.push_back(entry->first);
+    }
+  }
+  return routes;
+}
+
+// Name: CountAt(int)
+// Desc: Returns how many routes stop at an airport
+// Preconditions: None
+// Postconditions: Returns the number of distinct routes under id
+int RouteIndex::CountAt(int id)
+{
+  auto airport = m_stops.find(id);
+  return (airport == m_stops.end()) ? 0 : airport->second.size();
+}
+
+// Name: Touch(Route*)
+// Desc: Records that an indexed route was reordered
+// Preconditions: None
+// Postconditions: route is in the next changed list
+void RouteIndex::Touch(Route *route)
+{
+  m_changed.insert(route);
+}
+
+// Name: Drop(Route*)
+// Desc: Records that an indexed route is being deleted
+// Preconditions: route is not used again
+// Postconditions: route is in the next dropped list only
+void RouteIndex::Drop(Route *route)
+{
+  m_changed.erase(route);
+  m_dropped.insert(route);
+}
+
+// Name: TakeChanges(vector<Route*>&, vector<Route*>&)
+// Desc: Hands over the routes changed and deleted since the last call
+// Preconditions: None
+// Postconditions: Both lists are filled and the index's are empty
+void RouteIndex::TakeChanges(vector<Route *> &changed, vector<Route *> &dropped)
+{
+  changed.assign(m_changed.begin(), m_changed.end());
+  dropped.assign(m_dropped.begin(), m_dropped.end());
+  m_changed.clear();
+  m_dropped.clear();
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the heap held by the index
+// Preconditions: None
+// Postconditions: usage includes the outer and every inner table
+void RouteIndex::AddMemory(MemoryUsage &usage)
+{
+  AddHashMap(usage, m_stops);
+  for (auto airport = m_stops.begin(); airport != m_stops.end(); ++airport)
+  {
+    AddHashMap(usage, airport->second);
+  }
+  AddHashMap(usage, m_changed);
+  AddHashMap(usage, m_dropped);
+}
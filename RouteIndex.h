@@ -0,0 +1,76 @@
+#ifndef ROUTEINDEX_H
+#define ROUTEINDEX_H
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Memory.h"
+using namespace std;
+
+class Route;
+
+class RouteIndex {
+ public:
+  // Name: RouteIndex() - Default Constructor
+  // Desc: Builds an empty airport to route index
+  // Preconditions: None
+  // Postconditions: No routes are indexed
+  RouteIndex();
+  // Name: AddStop(int, Route*)
+  // Desc: Records that a route stops at an airport. A route can stop at
+  //   the same airport more than once, each stop is counted
+  // Preconditions: id is a stable catalog id (ignored if negative)
+  // Postconditions: route is listed under id
+  void AddStop(int id, Route *route);
+  // Name: RemoveStop(int, Route*)
+  // Desc: Forgets one stop of a route at an airport
+  // Preconditions: The stop was added with AddStop
+  // Postconditions: route is no longer listed under id once its last
+  //   stop there is removed
+  void RemoveStop(int id, Route *route);
+  // Name: RoutesAt(int)
+  // Desc: Returns every route that stops at an airport
+  // Preconditions: None
+  // Postconditions: Returns the routes in no particular order
+  vector<Route*> RoutesAt(int id);
+  // Name: CountAt(int)
+  // Desc: Returns how many routes stop at an airport
+  // Preconditions: None
+  // Postconditions: Returns the number of distinct routes under id
+  int CountAt(int id);
+  // Name: Touch(Route*)
+  // Desc: Records that an indexed route changed without gaining or
+  //   losing a stop (reordered)
+  // Preconditions: None
+  // Postconditions: route is in the next TakeChanges' changed list
+  void Touch(Route *route);
+  // Name: Drop(Route*)
+  // Desc: Records that an indexed route is being deleted, after its
+  //   stops were removed
+  // Preconditions: route is not used again (its address may be)
+  // Postconditions: route is in the next TakeChanges' dropped list
+  //   and not in its changed list
+  void Drop(Route *route);
+  // Name: TakeChanges(vector<Route*>&, vector<Route*>&)
+  // Desc: Hands over the routes that gained, lost or reordered a stop
+  //   and those deleted since the last call, so a copy of the routes
+  //   (for example their shapes) can redo only those. An address can be
+  //   in both lists when a new route took a deleted one's place; the
+  //   dropped list is to be handled first. Dropped addresses are only
+  //   keys, never to be followed
+  // Preconditions: None
+  // Postconditions: Both lists are filled and the index's are empty
+  void TakeChanges(vector<Route *> &changed, vector<Route *> &dropped);
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the heap held by the index
+  // Preconditions: None
+  // Postconditions: usage includes the outer and every inner table
+  void AddMemory(MemoryUsage &usage);
+ private:
+  unordered_map<int, unordered_map<Route *, int> > m_stops; //Airport id to routes and their stop count there
+  unordered_set<Route *> m_changed; //Routes that gained, lost or reordered a stop since TakeChanges
+  unordered_set<Route *> m_dropped; //Routes deleted since TakeChanges
+};
+
+#endif
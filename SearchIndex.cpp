@@ -0,0 +1,410 @@
+/*****************************************
+** File:    SearchIndex.cpp
+** Description: This file implements the prefix and typo tolerant airport search used when building routes
+***********************************************/
+
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cctype>
+using namespace std;
+
+// Name: Normalize(string)
+// Desc: Upper cases a string and squeezes runs of spaces
+// Preconditions: None
+// Postconditions: Returns the normalized string
+static string Normalize(string text)
+{
+  string result;
+  for (size_t i = 0; i < text.size(); i++)
+  {
+    char letter = toupper(static_cast<unsigned char>(text[i]));
+    if (isspace(static_cast<unsigned char>(letter)))
+    {
+      if (!result.empty() && result.back() != ' ')
+      {
+        result += ' ';
+      }
+    }
+    else
+    {
+      result += letter;
+    }
+  }
+  if (!result.empty() && result.back() == ' ')
+  {
+    result.pop_back();
+  }
+  return result;
+}
+
+// Name: BetterMatch
+// Desc: Orders matches best first (ties by catalog order)
+// Preconditions: None
+// Postconditions: Returns true if first ranks ahead of second
+static bool BetterMatch(const SearchMatch &first, const SearchMatch &second)
+{
+  if (first.m_score != second.m_score)
+  {
+    return first.m_score > second.m_score;
+  }
+  return first.m_index < second.m_index;
+}
+
+// Name: KeepBest(vector<SearchMatch>&, int)
+// Desc: Removes duplicate airports (keeping their best score), sorts
+//   and trims a list of matches
+// Preconditions: None
+// Postconditions: matches holds at most limit unique airports, best first
+static void KeepBest(vector<SearchMatch> &matches, int limit)
+{
+  sort(matches.begin(), matches.end(), BetterMatch);
+  vector<SearchMatch> unique;
+  for (size_t i = 0; i < matches.size() && static_cast<int>(unique.size()) < limit; i++)
+  {
+    bool seen = false;
+    for (size_t j = 0; j < unique.size() && !seen; j++)
+    {
+      seen = unique[j].m_index == matches[i].m_index;
+    }
+    if (!seen)
+    {
+      unique.push_back(matches[i]);
+    }
+  }
+  matches.swap(unique);
+}
+
+// Name: SearchIndex() - Default Constructor
+// Desc: Builds an empty index with just the trie root
+// Preconditions: None
+// Postconditions: Index has no entries
+SearchIndex::SearchIndex()
+{
+  TrieNode root;
+  root.m_letter = '\0';
+  root.m_child = -1;
+  root.m_sibling = -1;
+  root.m_count = 0;
+  m_nodes.push_back(root);
+}
+
+// Name: Add(int, string, int)
+// Desc: Indexes one field of an airport. The whole field and each of
+//   its words go into the trie and the trigram lists
+// Preconditions: Finish has not been called
+// Postconditions: Field is indexed under the airport index
+void SearchIndex::Add(int index, string text, int weight)
+{
+  string field = Normalize(text);
+  if (field.empty())
+  {
+    return;
+  }
+
+  // Whole field first so multi word queries like "NEW YORK" match
+  AddWord(index, field, weight);
+
+  size_t start = 0;
+  size_t space = field.find(' ');
+  if (space == string::npos)
+  {
+    return; // single word, already added
+  }
+  while (start < field.size())
+  {
+    space = field.find(' ', start);
+    if (space == string::npos)
+    {
+      space = field.size();
+    }
+    AddWord(index, field.substr(start, space - start), weight);
+    start = space + 1;
+  }
+}
+
+// Name: AddWord(int, string, int)
+// Desc: Inserts a single word into the trie and trigram lists
+// Preconditions: word is upper case
+// Postconditions: Word is indexed
+void SearchIndex::AddWord(int index, string word, int weight)
+{
+  int node = 0;
+  for (size_t i = 0; i < word.size(); i++)
+  {
+    int child = m_nodes[node].m_child;
+    while (child != -1 && m_nodes[child].m_letter != word[i])
+    {
+      child = m_nodes[child].m_sibling;
+    }
+    if (child == -1)
+    {
+      // New node becomes the first child of the current node
+      TrieNode created;
+      created.m_letter = word[i];
+      created.m_child = -1;
+      created.m_sibling = m_nodes[node].m_child;
+      created.m_count = 0;
+      child = m_nodes.size();
+      m_nodes.push_back(created);
+      m_nodes[node].m_child = child;
+    }
+    node = child;
+  }
+
+  // Heavier fields rank first, shorter words (closer to exact) next
+  SearchMatch hit;
+  hit.m_index = index;
+  hit.m_score = weight * 1000 - static_cast<int>(word.size());
+  m_nodes[node].m_hits.push_back(hit);
+
+  Token token;
+  token.m_text = word;
+  token.m_index = index;
+  token.m_weight = weight;
+  vector<uint32_t> keys = Trigrams(word);
+  for (size_t i = 0; i < keys.size(); i++)
+  {
+    vector<int> &tokens = m_trigrams[keys[i]];
+    if (tokens.empty() || tokens.back() != static_cast<int>(m_tokens.size()))
+    {
+      tokens.push_back(m_tokens.size());
+    }
+  }
+  m_tokens.push_back(token);
+}
+
+// Name: Finish()
+// Desc: Ranks the hits under every busy trie node so prefix
+//   searches do not have to walk large subtrees
+// Preconditions: Every field was added
+// Postconditions: Index is ready for Search
+void SearchIndex::Finish()
+{
+  RankSubtree(0);
+}
+
+// Name: RankSubtree(int)
+// Desc: Fills m_count and m_best below a node (post order)
+// Preconditions: Trie is complete
+// Postconditions: Busy nodes hold their best SEARCH_LIMIT hits
+void SearchIndex::RankSubtree(int node)
+{
+  int count = m_nodes[node].m_hits.size();
+  for (int child = m_nodes[node].m_child; child != -1; child = m_nodes[child].m_sibling)
+  {
+    RankSubtree(child);
+    count += m_nodes[child].m_count;
+  }
+  m_nodes[node].m_count = count;
+
+  if (count > SEARCH_CACHE_MIN)
+  {
+    // Children are already ranked (or small), so this stays cheap
+    vector<SearchMatch> best;
+    Collect(node, SEARCH_LIMIT, best);
+    KeepBest(best, SEARCH_LIMIT);
+    m_nodes[node].m_best = best;
+  }
+}
+
+// Name: Collect(int, int, vector<SearchMatch>&)
+// Desc: Gathers the hits under a node, using ranked lists that hold at
+//   least limit hits
+// Preconditions: Finish was called
+// Postconditions: Hits are appended to found
+void SearchIndex::Collect(int node, int limit, vector<SearchMatch> &found)
+{
+  found.insert(found.end(), m_nodes[node].m_hits.begin(), m_nodes[node].m_hits.end());
+  for (int child = m_nodes[node].m_child; child != -1; child = m_nodes[child].m_sibling)
+  {
+    if (static_cast<int>(m_nodes[child].m_best.size()) >= limit)
+    {
+      found.insert(found.end(), m_nodes[child].m_best.begin(), m_nodes[child].m_best.end());
+    }
+    else
+    {
+      Collect(child, limit, found);
+    }
+  }
+}
+
+// Name: Search(string, int)
+// Desc: Returns the best matches for a query. Prefix matches on any
+//   word of the code, name, city or country rank first, then fuzzy
+//   trigram matches within a small edit distance (typos)
+// Preconditions: Finish was called
+// Postconditions: Returns at most limit matches, best first
+vector<SearchMatch> SearchIndex::Search(string query, int limit)
+{
+  vector<SearchMatch> found;
+  string word = Normalize(query);
+  if (word.empty() || limit <= 0)
+  {
+    return found;
+  }
+
+  // Prefix matches: walk the trie down to the query
+  int node = 0;
+  for (size_t i = 0; i < word.size() && node != -1; i++)
+  {
+    int child = m_nodes[node].m_child;
+    while (child != -1 && m_nodes[child].m_letter != word[i])
+    {
+      child = m_nodes[child].m_sibling;
+    }
+    node = child;
+  }
+  if (node != -1)
+  {
+    if (static_cast<int>(m_nodes[node].m_best.size()) >= limit)
+    {
+      found = m_nodes[node].m_best;
+    }
+    else
+    {
+      Collect(node, limit, found); // also when limit is over the ranked list's SEARCH_LIMIT
+    }
+    KeepBest(found, limit);
+  }
+  if (static_cast<int>(found.size()) >= limit || word.size() < 4)
+  {
+    return found;
+  }
+
+  // Fuzzy matches: count shared trigrams per word, then confirm the
+  // most promising words with a bounded edit distance
+  vector<uint32_t> keys = Trigrams(word);
+  unordered_map<int, int> shared; // token id to shared trigram count
+  for (size_t i = 0; i < keys.size(); i++)
+  {
+    auto list = m_trigrams.find(keys[i]);
+    if (list == m_trigrams.end())
+    {
+      continue;
+    }
+    for (size_t j = 0; j < list->second.size(); j++)
+    {
+      shared[list->second[j]]++;
+    }
+  }
+
+  int bound = word.size() <= 5 ? 1 : 2; // typos allowed
+  // One edit touches at most three trigrams
+  int needed = static_cast<int>(keys.size()) - 3 * bound;
+  if (needed < 1)
+  {
+    needed = 1;
+  }
+  vector<SearchMatch> fuzzy;
+  for (auto entry = shared.begin(); entry != shared.end(); ++entry)
+  {
+    if (entry->second < needed)
+    {
+      continue;
+    }
+    Token &token = m_tokens[entry->first];
+    // A typo in the query should still find longer words it is a prefix of
+    string target = token.m_text.substr(0, word.size() + bound);
+    int distance = EditDistance(word, target, bound);
+    int prefixDistance = EditDistance(word, token.m_text.substr(0, word.size()), bound);
+    if (prefixDistance < distance)
+    {
+      distance = prefixDistance;
+    }
+    if (distance <= bound)
+    {
+      SearchMatch hit;
+      hit.m_index = token.m_index;
+      // Always below every prefix match of the same field
+      hit.m_score = token.m_weight * 1000 - 500 * (distance + 1) - static_cast<int>(token.m_text.size());
+      fuzzy.push_back(hit);
+    }
+  }
+  found.insert(found.end(), fuzzy.begin(), fuzzy.end());
+  KeepBest(found, limit);
+  return found;
+}
+
+// Name: AddMemory(MemoryUsage&, MemoryUsage&)
+// Desc: Counts the heap held by the index. The ranked lists of busy
+//   nodes only speed up searches, so they are counted as cache
+// Preconditions: None
+// Postconditions: index and cache include the heap of the index
+void SearchIndex::AddMemory(MemoryUsage &index, MemoryUsage &cache)
+{
+  AddVector(index, m_nodes);
+  for (size_t i = 0; i < m_nodes.size(); i++)
+  {
+    AddVector(index, m_nodes[i].m_hits);
+    AddVector(cache, m_nodes[i].m_best);
+  }
+  AddVector(index, m_tokens);
+  for (size_t i = 0; i < m_tokens.size(); i++)
+  {
+    AddString(index, m_tokens[i].m_text);
+  }
+  AddHashMap(index, m_trigrams);
+  for (auto trigram = m_trigrams.begin(); trigram != m_trigrams.end(); ++trigram)
+  {
+    AddVector(index, trigram->second);
+  }
+}
+
+// Name: Trigrams(string)
+// Desc: Packs every trigram of a padded word into an integer
+// Preconditions: None
+// Postconditions: Returns the trigram keys of word
+vector<uint32_t> SearchIndex::Trigrams(string word)
+{
+  // Pad the front so the first letters carry their own trigrams
+  string padded = "  " + word;
+  vector<uint32_t> keys;
+  for (size_t i = 0; i + 2 < padded.size(); i++)
+  {
+    uint32_t key = (static_cast<unsigned char>(padded[i]) << 16) |
+                   (static_cast<unsigned char>(padded[i + 1]) << 8) |
+                   static_cast<unsigned char>(padded[i + 2]);
+    if (find(keys.begin(), keys.end(), key) == keys.end())
+    {
+      keys.push_back(key);
+    }
+  }
+  return keys;
+}
+
+// Name: EditDistance(string, string, int)
+// Desc: Levenshtein distance that stops early once it passes the bound
+// Preconditions: None
+// Postconditions: Returns the distance, or bound + 1 if it is larger
+int SearchIndex::EditDistance(const string &first, const string &second, int bound)
+{
+  int lengthGap = static_cast<int>(first.size()) - static_cast<int>(second.size());
+  if (lengthGap > bound || -lengthGap > bound)
+  {
+    return bound + 1;
+  }
+
+  vector<int> previous(second.size() + 1);
+  vector<int> current(second.size() + 1);
+  for (size_t j = 0; j <= second.size(); j++)
+  {
+    previous[j] = j;
+  }
+  for (size_t i = 1; i <= first.size(); i++)
+  {
+    current[0] = i;
+    int rowBest = current[0];
+    for (size_t j = 1; j <= second.size(); j++)
+    {
+      int cost = (first[i - 1] == second[j - 1]) ? 0 : 1;
+      current[j] = min(min(previous[j] + 1, current[j - 1] + 1), previous[j - 1] + cost);
+      rowBest = min(rowBest, current[j]);
+    }
+    if (rowBest > bound)
+    {
+      return bound + 1; // every path is already too far
+    }
+    previous.swap(current);
+  }
+  return min(previous[second.size()], bound + 1);
+}
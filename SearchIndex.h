@@ -0,0 +1,109 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Memory.h"
+using namespace std;
+
+// Constants used for ranking
+const int SEARCH_LIMIT = 10;       // Most matches returned by a search
+const int SEARCH_CACHE_MIN = 32;   // Trie nodes with more hits than this keep a ranked list
+const int WEIGHT_CODE = 4;         // Field weights, higher ranks first
+const int WEIGHT_CITY = 3;
+const int WEIGHT_NAME = 2;
+const int WEIGHT_COUNTRY = 1;
+
+// One ranked hit, m_index is the position of the airport in its catalog
+struct SearchMatch {
+  int m_index; //Airport index
+  int m_score; //Higher is better
+};
+
+class SearchIndex {
+ public:
+  // Name: SearchIndex() - Default Constructor
+  // Desc: Builds an empty index with just the trie root
+  // Preconditions: None
+  // Postconditions: Index has no entries
+  SearchIndex();
+  // Name: Add(int, string, int)
+  // Desc: Indexes one field of an airport. The whole field and each of
+  //   its words go into the trie and the trigram lists
+  // Preconditions: Finish has not been called
+  // Postconditions: Field is indexed under the airport index
+  void Add(int index, string text, int weight);
+  // Name: Finish()
+  // Desc: Ranks the hits under every busy trie node so prefix
+  //   searches do not have to walk large subtrees
+  // Preconditions: Every field was added
+  // Postconditions: Index is ready for Search
+  void Finish();
+  // Name: Search(string, int)
+  // Desc: Returns the best matches for a query. Prefix matches on any
+  //   word of the code, name, city or country rank first, then fuzzy
+  //   trigram matches within a small edit distance (typos)
+  // Preconditions: Finish was called
+  // Postconditions: Returns at most limit matches, best first. A
+  //   limit over SEARCH_LIMIT walks the subtrees of busy trie nodes
+  //   rather than their ranked lists, so it costs more but is complete
+  vector<SearchMatch> Search(string query, int limit);
+  // Name: AddMemory(MemoryUsage&, MemoryUsage&)
+  // Desc: Counts the heap held by the index. The ranked lists of busy
+  //   nodes only speed up searches, so they are counted as cache
+  // Preconditions: None
+  // Postconditions: index and cache include the heap of the index
+  void AddMemory(MemoryUsage &index, MemoryUsage &cache);
+ private:
+  struct TrieNode {
+    char m_letter;    //Letter on the edge into this node
+    int m_child;      //First child or -1
+    int m_sibling;    //Next sibling or -1
+    int m_count;      //Hits in this subtree
+    vector<SearchMatch> m_hits; //Words that end here
+    vector<SearchMatch> m_best; //Ranked subtree hits (busy nodes only)
+  };
+  struct Token {
+    string m_text;  //Indexed word
+    int m_index;    //Airport index
+    int m_weight;   //Field weight
+  };
+
+  // Name: AddWord(int, string, int)
+  // Desc: Inserts a single word into the trie and trigram lists
+  // Preconditions: word is upper case
+  // Postconditions: Word is indexed
+  void AddWord(int index, string word, int weight);
+  // Name: RankSubtree(int)
+  // Desc: Fills m_count and m_best below a node (post order)
+  // Preconditions: Trie is complete
+  // Postconditions: Busy nodes hold their best SEARCH_LIMIT hits
+  void RankSubtree(int node);
+  // Name: Collect(int, int, vector<SearchMatch>&)
+  // Desc: Gathers the hits under a node, taking a child's ranked list
+  //   instead of its subtree when the list holds at least limit hits
+  //   (the child's best limit airports are then all in it)
+  // Preconditions: Finish was called
+  // Postconditions: Hits are appended to found, every one of the best
+  //   limit airports under node among them
+  void Collect(int node, int limit, vector<SearchMatch> &found);
+  // Name: Trigrams(string)
+  // Desc: Packs every trigram of a padded word into an integer
+  // Preconditions: None
+  // Postconditions: Returns the trigram keys of word
+  static vector<uint32_t> Trigrams(string word);
+  // Name: EditDistance(string, string, int)
+  // Desc: Levenshtein distance that stops early once it passes the bound
+  // Preconditions: None
+  // Postconditions: Returns the distance, or bound + 1 if it is larger
+  static int EditDistance(const string &first, const string &second, int bound);
+
+  vector<TrieNode> m_nodes; //Trie, node 0 is the root
+  vector<Token> m_tokens; //Every indexed word
+  unordered_map<uint32_t, vector<int> > m_trigrams; //Trigram to token ids
+};
+
+#endif
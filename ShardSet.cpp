@@ -0,0 +1,530 @@
+/*****************************************
+** File:    ShardSet.cpp
+** Description: This file implements the catalog split by longitude band across local worker processes
+***********************************************/
+
+#include "ShardSet.h"
+#include "FeedStream.h"
+#include "Navigator.h"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+using namespace std;
+
+// Name: ShardColumn(double)
+// Desc: Maps a longitude to its one degree column, the same columns as
+//   the catalog grid
+// Preconditions: None
+// Postconditions: Returns a column in [0, GRID_COLUMNS)
+static int ShardColumn(double west)
+{
+  int column = static_cast<int>(floor(west + 180.0)) % GRID_COLUMNS;
+  return column < 0 ? column + GRID_COLUMNS : column;
+}
+
+// Name: ReadLine(int, string&, string&)
+// Desc: Reads one line from a socket. Bytes past the line stay in pending
+// Preconditions: pending holds what the last call read past its line
+// Postconditions: Returns false if the other end closed first
+static bool ReadLine(int socket, string &pending, string &line)
+{
+  size_t end = pending.find('\n');
+  while (end == string::npos)
+  {
+    char buffer[4096];
+    ssize_t got = read(socket, buffer, sizeof(buffer));
+    if (got <= 0)
+    {
+      return false;
+    }
+    pending.append(buffer, got);
+    end = pending.find('\n');
+  }
+  line = pending.substr(0, end);
+  pending.erase(0, end + 1);
+  return true;
+}
+
+// Name: WriteAll(int, string)
+// Desc: Writes all of text to a socket
+// Preconditions: None
+// Postconditions: Returns false if the other end is gone
+static bool WriteAll(int socket, const string &text)
+{
+  size_t sent = 0;
+  while (sent < text.size())
+  {
+    ssize_t wrote = write(socket, text.data() + sent, text.size() - sent);
+    if (wrote <= 0)
+    {
+      return false;
+    }
+    sent += wrote;
+  }
+  return true;
+}
+
+// Name: WriteAirport(ostream&, double, Airport*)
+// Desc: Writes one reply line: the miles, then the airport as a line of
+//   the data file so the coordinator can parse it with ParseAirport
+// Preconditions: reply keeps enough precision for the coordinates
+// Postconditions: One line is written
+static void WriteAirport(ostream &reply, double miles, Airport *airport)
+{
+  reply << miles << ' ' << airport->GetCode() << ',' << airport->GetName() << ',' << airport->GetCity() << ','
+        << airport->GetCountry() << ',' << airport->GetNorth() << ',' << airport->GetWest() << '\n';
+}
+
+// Name: ServeShard(int, string, int, int)
+// Desc: Body of a worker process. Loads the airports of its band of
+//   columns and answers one request per line, each reply ends with "end":
+//     size                    airports held
+//     find <code>             the airport, if held
+//     near <north> <west> <mi> airports within mi miles
+//     quit                    stops
+// Preconditions: Runs in the forked child
+// Postconditions: Returns when told to quit or the coordinator is gone
+static void ServeShard(int socket, string fileName, int firstColumn, int lastColumn)
+{
+  // Keep only this band, loaded straight from a window of the file at a time
+  ifstream file(fileName);
+  FeedStream stream(file, FEED_WINDOW_DEFAULT);
+  shared_ptr<Catalog> catalog(new Catalog());
+  catalog->Load(stream, [firstColumn, lastColumn](const FeedAirport &airport) {
+    int column = ShardColumn(airport.m_west);
+    return column >= firstColumn && column < lastColumn;
+  });
+  file.close();
+
+  string pending, request;
+  while (ReadLine(socket, pending, request))
+  {
+    istringstream words(request);
+    string command;
+    words >> command;
+    if (command == "quit")
+    {
+      break;
+    }
+
+    ostringstream reply;
+    reply << setprecision(12);
+    if (command == "size")
+    {
+      reply << catalog->GetSize() << '\n';
+    }
+    else if (command == "find")
+    {
+      string code;
+      words >> code;
+      Airport *airport = catalog->GetAirport(catalog->FindCode(code));
+      if (airport != nullptr)
+      {
+        WriteAirport(reply, 0.0, airport);
+      }
+    }
+    else if (command == "near")
+    {
+      double north = 0.0, west = 0.0, miles = 0.0;
+      words >> north >> west >> miles;
+      vector<int> found = Navigator::AirportsNear(catalog, north, west, miles);
+      for (size_t i = 0; i < found.size(); i++)
+      {
+        Airport *airport = catalog->GetAirport(found[i]);
+        WriteAirport(reply, Haversine::Miles(north, west, airport->GetNorth(), airport->GetWest()), airport);
+      }
+    }
+    reply << "end\n";
+    if (!WriteAll(socket, reply.str()))
+    {
+      break;
+    }
+  }
+}
+
+// Name: ShardSet() - Default Constructor
+// Desc: Builds a coordinator with no workers
+// Preconditions: None
+// Postconditions: No workers are running
+ShardSet::ShardSet()
+{
+  for (int i = 0; i < GRID_COLUMNS; i++)
+  {
+    m_columnShard[i] = 0;
+  }
+}
+
+// Name: ~ShardSet() - Destructor
+// Desc: Stops every worker
+// Preconditions: None
+// Postconditions: Workers have exited and been reaped
+ShardSet::~ShardSet()
+{
+  Stop();
+}
+
+// Name: Start(string, int)
+// Desc: Splits the airport file into longitude bands holding about the
+//   same number of airports and forks one worker per band. Each worker
+//   reads only its band of the file into its own Catalog and answers
+//   requests over a local socket
+// Preconditions: No workers are running
+// Postconditions: Returns false if the file could not be opened or
+//   a worker could not be started (workers already started are stopped)
+bool ShardSet::Start(string fileName, int shards)
+{
+  shards = max(1, min(shards, SHARD_MAX));
+
+  // Count the airports of every column, streaming so the coordinator
+  // never holds the catalog either
+  ifstream file(fileName);
+  if (!file.is_open())
+  {
+    cerr << "Unable to open file: " << fileName << endl;
+    return false;
+  }
+  vector<long> counts(GRID_COLUMNS, 0);
+  long total = 0;
+  FeedStream stream(file, FEED_WINDOW_DEFAULT);
+  while (stream.NextWindow())
+  {
+    vector<FeedAirport> &airports = stream.GetAirports();
+    for (size_t i = 0; i < airports.size(); i++)
+    {
+      counts[ShardColumn(airports[i].m_west)]++;
+      total++;
+    }
+  }
+  file.close();
+
+  // Close a band once it has its share of airports, keeping at least one
+  // column for every band still to come
+  vector<int> firstColumns(1, 0);
+  long seen = 0;
+  for (int column = 0; column < GRID_COLUMNS; column++)
+  {
+    int shard = firstColumns.size() - 1;
+    m_columnShard[column] = shard;
+    seen += counts[column];
+    int bandsLeft = shards - 1 - shard;
+    int columnsLeft = GRID_COLUMNS - 1 - column;
+    if (bandsLeft > 0 && (seen * shards >= total * (shard + 1) || columnsLeft == bandsLeft))
+    {
+      firstColumns.push_back(column + 1);
+    }
+  }
+  firstColumns.push_back(GRID_COLUMNS);
+
+  signal(SIGPIPE, SIG_IGN); // a dead worker shows up as a failed write
+  cout.flush(); // the child must not inherit unwritten output
+  for (int shard = 0; shard < shards; shard++)
+  {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+    {
+      Stop();
+      return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      close(sockets[0]);
+      close(sockets[1]);
+      Stop();
+      return false;
+    }
+    if (pid == 0)
+    {
+      // Worker: keep only its own end so the others see the coordinator go
+      close(sockets[0]);
+      for (size_t i = 0; i < m_workers.size(); i++)
+      {
+        close(m_workers[i].m_socket);
+      }
+      ServeShard(sockets[1], fileName, firstColumns[shard], firstColumns[shard + 1]);
+      close(sockets[1]);
+      _exit(0); // skip the coordinator's destructors
+    }
+    close(sockets[1]);
+
+    ShardWorker worker;
+    worker.m_pid = pid;
+    worker.m_socket = sockets[0];
+    worker.m_firstColumn = firstColumns[shard];
+    worker.m_lastColumn = firstColumns[shard + 1];
+    worker.m_size = 0;
+    m_workers.push_back(worker);
+  }
+
+  // Waits for every worker to finish loading
+  vector<int> all;
+  for (int shard = 0; shard < shards; shard++)
+  {
+    all.push_back(shard);
+  }
+  vector<vector<string> > replies = Ask(all, "size");
+  for (int shard = 0; shard < shards; shard++)
+  {
+    if (replies[shard].empty())
+    {
+      Stop();
+      return false;
+    }
+    m_workers[shard].m_size = atoi(replies[shard][0].c_str());
+  }
+  return true;
+}
+
+// Name: Stop()
+// Desc: Tells every worker to quit and waits for it
+// Preconditions: None
+// Postconditions: No workers are running
+void ShardSet::Stop()
+{
+  for (size_t i = 0; i < m_workers.size(); i++)
+  {
+    WriteAll(m_workers[i].m_socket, "quit\n");
+    close(m_workers[i].m_socket);
+  }
+  for (size_t i = 0; i < m_workers.size(); i++)
+  {
+    waitpid(m_workers[i].m_pid, nullptr, 0);
+  }
+  m_workers.clear();
+}
+
+// Name: GetWorkers()
+// Desc: Returns the running workers, for reporting
+// Preconditions: None
+// Postconditions: Returns m_workers
+const vector<ShardWorker> &ShardSet::GetWorkers()
+{
+  return m_workers;
+}
+
+// Name: Find(string, ShardHit&)
+// Desc: Asks every shard for an airport code
+// Preconditions: Start succeeded
+// Postconditions: Returns true and fills found if some shard has it
+bool ShardSet::Find(string code, ShardHit &found)
+{
+  vector<int> all;
+  for (size_t shard = 0; shard < m_workers.size(); shard++)
+  {
+    all.push_back(shard);
+  }
+  vector<vector<string> > replies = Ask(all, "find " + code);
+  for (size_t shard = 0; shard < replies.size(); shard++)
+  {
+    if (!replies[shard].empty())
+    {
+      istringstream words(replies[shard][0]);
+      string line;
+      words >> found.m_miles;
+      getline(words >> ws, line);
+      ParseFeedAirport(line, found.m_airport);
+      found.m_shard = all[shard];
+      return true;
+    }
+  }
+  return false;
+}
+
+// Name: Near(double, double, double)
+// Desc: Finds every airport within miles of a point. The request goes
+//   only to shards whose band the radius reaches, all of them are sent
+//   before any reply is read so the workers search in parallel
+// Preconditions: Start succeeded
+// Postconditions: Returns the merged hits, nearest first
+vector<ShardHit> ShardSet::Near(double north, double west, double miles)
+{
+  vector<int> shards = ShardsFor(north, west, miles);
+  ostringstream request;
+  request << setprecision(12) << "near " << north << ' ' << west << ' ' << miles;
+  vector<vector<string> > replies = Ask(shards, request.str());
+
+  vector<ShardHit> hits;
+  unordered_map<string, bool> listed; // a code loaded by two shards is listed once
+  for (size_t i = 0; i < replies.size(); i++)
+  {
+    for (size_t j = 0; j < replies[i].size(); j++)
+    {
+      istringstream words(replies[i][j]);
+      string line;
+      ShardHit hit;
+      words >> hit.m_miles;
+      getline(words >> ws, line);
+      ParseFeedAirport(line, hit.m_airport);
+      hit.m_shard = shards[i];
+      if (!listed[hit.m_airport.m_code])
+      {
+        listed[hit.m_airport.m_code] = true;
+        hits.push_back(hit);
+      }
+    }
+  }
+  sort(hits.begin(), hits.end(), [](const ShardHit &first, const ShardHit &second) {
+    return first.m_miles < second.m_miles;
+  });
+  return hits;
+}
+
+// Name: Path(string, string, double)
+// Desc: Shortest itinerary with no leg over maxLeg miles. A* search on
+//   the coordinator, the legs out of each airport come from a Near
+//   fan out, so no process ever holds the whole leg graph
+// Preconditions: Start succeeded
+// Postconditions: Returns the stops from origin to destination with
+//   the miles flown so far, empty if there is none (or the search
+//   expanded SHARD_PATH_LIMIT airports first)
+vector<ShardHit> ShardSet::Path(string from, string to, double maxLeg)
+{
+  vector<ShardHit> path;
+  ShardHit origin, goal;
+  if (!Find(from, origin) || !Find(to, goal))
+  {
+    return path;
+  }
+  double goalNorth = goal.m_airport.m_north;
+  double goalWest = goal.m_airport.m_west;
+
+  // Every airport reached so far, by code
+  vector<ShardHit> reached(1, origin);
+  vector<int> parent(1, -1);
+  vector<bool> done(1, false);
+  unordered_map<string, int> index;
+  index[from] = 0;
+  reached[0].m_miles = 0.0;
+
+  // Straight line miles to the goal never overestimate, so the first
+  // time the goal comes off the queue its miles are the shortest
+  typedef pair<double, int> Entry;
+  priority_queue<Entry, vector<Entry>, greater<Entry> > open;
+  open.push(Entry(Haversine::Miles(origin.m_airport.m_north, origin.m_airport.m_west, goalNorth, goalWest), 0));
+  int expanded = 0;
+  while (!open.empty() && expanded < SHARD_PATH_LIMIT)
+  {
+    int at = open.top().second;
+    open.pop();
+    if (done[at])
+    {
+      continue;
+    }
+    done[at] = true;
+    if (reached[at].m_airport.m_code == to)
+    {
+      for (int stop = at; stop != -1; stop = parent[stop])
+      {
+        path.push_back(reached[stop]);
+      }
+      reverse(path.begin(), path.end());
+      return path;
+    }
+    expanded++;
+
+    double north = reached[at].m_airport.m_north;
+    double west = reached[at].m_airport.m_west;
+    vector<ShardHit> legs = Near(north, west, maxLeg);
+    for (size_t i = 0; i < legs.size(); i++)
+    {
+      double miles = reached[at].m_miles + legs[i].m_miles;
+      auto found = index.find(legs[i].m_airport.m_code);
+      int next = 0;
+      if (found == index.end())
+      {
+        next = reached.size();
+        index[legs[i].m_airport.m_code] = next;
+        reached.push_back(legs[i]);
+        parent.push_back(at);
+        done.push_back(false);
+      }
+      else
+      {
+        next = found->second;
+        if (done[next] || reached[next].m_miles <= miles)
+        {
+          continue;
+        }
+        parent[next] = at;
+      }
+      reached[next].m_miles = miles;
+      open.push(Entry(miles + Haversine::Miles(legs[i].m_airport.m_north, legs[i].m_airport.m_west,
+                                               goalNorth, goalWest),
+                      next));
+    }
+  }
+  return path;
+}
+
+// Name: ShardsFor(double, double, double)
+// Desc: Returns the shards whose band a radius around a point reaches
+// Preconditions: Start succeeded
+// Postconditions: Returns shard numbers in order
+vector<int> ShardSet::ShardsFor(double north, double west, double miles)
+{
+  vector<bool> wanted(m_workers.size(), false);
+
+  // Same box as Navigator::AirportsNear
+  double northSpan = miles / EARTH_RADIUS * RAD_2_DEG;
+  double widest = fabs(north) + northSpan;
+  double westSpan = 360.0;
+  if (widest < 89.0)
+  {
+    westSpan = northSpan / cos(widest * DEG_2_RAD);
+  }
+  if (westSpan >= 180.0)
+  {
+    wanted.assign(m_workers.size(), true); // reaches every longitude
+  }
+  else
+  {
+    int low = static_cast<int>(floor(west - westSpan + 180.0));
+    int high = static_cast<int>(floor(west + westSpan + 180.0));
+    for (int column = low; column <= high; column++)
+    {
+      wanted[m_columnShard[ShardColumn(column - 180.0)]] = true;
+    }
+  }
+
+  vector<int> shards;
+  for (size_t shard = 0; shard < wanted.size(); shard++)
+  {
+    if (wanted[shard])
+    {
+      shards.push_back(shard);
+    }
+  }
+  return shards;
+}
+
+// Name: Ask(vector<int>&, string)
+// Desc: Sends a request to several shards, then collects every reply
+// Preconditions: Start succeeded
+// Postconditions: Returns the reply lines of each shard, in the order given
+vector<vector<string> > ShardSet::Ask(const vector<int> &shards, string request)
+{
+  request += '\n';
+  vector<bool> sent(shards.size(), false);
+  for (size_t i = 0; i < shards.size(); i++)
+  {
+    sent[i] = WriteAll(m_workers[shards[i]].m_socket, request);
+  }
+
+  vector<vector<string> > replies(shards.size());
+  for (size_t i = 0; i < shards.size(); i++)
+  {
+    ShardWorker &worker = m_workers[shards[i]];
+    string line;
+    while (sent[i] && ReadLine(worker.m_socket, worker.m_pending, line) && line != "end")
+    {
+      replies[i].push_back(line);
+    }
+  }
+  return replies;
+}
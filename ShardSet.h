@@ -0,0 +1,100 @@
+#ifndef SHARDSET_H
+#define SHARDSET_H
+
+#include "Catalog.h"
+#include "FeedStream.h"
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+using namespace std;
+
+const int SHARD_MAX = 64; // Most worker processes a ShardSet starts
+const int SHARD_PATH_LIMIT = 20000; // Most airports a sharded path search expands
+
+// One airport returned by a shard, with its miles from the query point
+struct ShardHit {
+  FeedAirport m_airport; //The airport's fields as the shard sent them (not interned)
+  double m_miles;    //Miles from the query point (or along a path)
+  int m_shard;       //Shard that holds the airport
+};
+
+// One worker process and the longitude band it holds
+struct ShardWorker {
+  pid_t m_pid;        //Worker process
+  int m_socket;       //Coordinator end of the socket pair
+  string m_pending;   //Bytes read past the last full reply line
+  int m_firstColumn;  //First one degree column of the band (see Catalog.h)
+  int m_lastColumn;   //One past the last column of the band
+  int m_size;         //Airports the worker loaded
+};
+
+class ShardSet {
+ public:
+  // Name: ShardSet() - Default Constructor
+  // Desc: Builds a coordinator with no workers
+  // Preconditions: None
+  // Postconditions: No workers are running
+  ShardSet();
+  // Name: ~ShardSet() - Destructor
+  // Desc: Stops every worker
+  // Preconditions: None
+  // Postconditions: Workers have exited and been reaped
+  ~ShardSet();
+  // Name: Start(string, int)
+  // Desc: Splits the airport file into longitude bands holding about the
+  //   same number of airports and forks one worker per band. Each worker
+  //   reads only its band of the file into its own Catalog and answers
+  //   requests over a local socket
+  // Preconditions: No workers are running
+  // Postconditions: Returns false if the file could not be opened or
+  //   a worker could not be started (workers already started are stopped)
+  bool Start(string fileName, int shards);
+  // Name: Stop()
+  // Desc: Tells every worker to quit and waits for it
+  // Preconditions: None
+  // Postconditions: No workers are running
+  void Stop();
+  // Name: GetWorkers()
+  // Desc: Returns the running workers, for reporting
+  // Preconditions: None
+  // Postconditions: Returns m_workers
+  const vector<ShardWorker>& GetWorkers();
+  // Name: Find(string, ShardHit&)
+  // Desc: Asks every shard for an airport code
+  // Preconditions: Start succeeded
+  // Postconditions: Returns true and fills found if some shard has it
+  bool Find(string code, ShardHit &found);
+  // Name: Near(double, double, double)
+  // Desc: Finds every airport within miles of a point. The request goes
+  //   only to shards whose band the radius reaches, all of them are sent
+  //   before any reply is read so the workers search in parallel
+  // Preconditions: Start succeeded
+  // Postconditions: Returns the merged hits, nearest first
+  vector<ShardHit> Near(double north, double west, double miles);
+  // Name: Path(string, string, double)
+  // Desc: Shortest itinerary with no leg over maxLeg miles. A* search on
+  //   the coordinator, the legs out of each airport come from a Near
+  //   fan out, so no process ever holds the whole leg graph
+  // Preconditions: Start succeeded
+  // Postconditions: Returns the stops from origin to destination with
+  //   the miles flown so far, empty if there is none (or the search
+  //   expanded SHARD_PATH_LIMIT airports first)
+  vector<ShardHit> Path(string from, string to, double maxLeg);
+ private:
+  // Name: ShardsFor(double, double, double)
+  // Desc: Returns the shards whose band a radius around a point reaches
+  // Preconditions: Start succeeded
+  // Postconditions: Returns shard numbers in order
+  vector<int> ShardsFor(double north, double west, double miles);
+  // Name: Ask(vector<int>&, string)
+  // Desc: Sends a request to several shards, then collects every reply
+  // Preconditions: Start succeeded
+  // Postconditions: Returns the reply lines of each shard, in the order given
+  vector<vector<string> > Ask(const vector<int> &shards, string request);
+
+  vector<ShardWorker> m_workers; //Running workers, by shard number
+  int m_columnShard[GRID_COLUMNS]; //Shard that holds each one degree column
+};
+
+#endif
@@ -0,0 +1,473 @@
+/*****************************************
+** File:    SimilarityIndex.cpp
+** Description: This file implements the route shape index and its filter and refine similarity search
+***********************************************/
+
+#include "SimilarityIndex.h"
+#include "DistanceModel.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <cmath>
+using namespace std;
+
+const int BOUND_BLOCK = 4096; // Shapes a thread bounds at a time
+const int REFINE_BLOCK = 64;  // Candidates a thread refines at a time
+const int REFINE_FIRST = 64;  // Fewest shapes refined first, those with the smallest bounds
+
+// Name: ChordMiles(double)
+// Desc: Converts the straight line between two unit vectors to great
+//   circle miles (the same answer as Haversine)
+// Preconditions: chord >= 0
+// Postconditions: Returns the miles
+static double ChordMiles(double chord)
+{
+  return 2.0 * double(EARTH_RADIUS) * asin(min(1.0, chord / 2.0));
+}
+
+// Name: BetterMatch
+// Desc: Orders matches nearest first (ties by shape number)
+// Preconditions: None
+// Postconditions: Returns true if first ranks ahead of second
+static bool BetterMatch(const SimilarMatch &first, const SimilarMatch &second)
+{
+  if (first.m_miles != second.m_miles)
+  {
+    return first.m_miles < second.m_miles;
+  }
+  return first.m_shape < second.m_shape;
+}
+
+// Name: Share(int, int, int, function)
+// Desc: Runs work(begin, end, thread) over [0, count) in blocks of
+//   block, each thread taking the next block as it finishes the last
+//   (blocks are handed out in order)
+// Preconditions: threads >= 1
+// Postconditions: Returns after every block is done
+static void Share(int count, int block, int threads, function<void(int, int, int)> work)
+{
+  atomic<int> next(0);
+  auto body = [&](int t) {
+    for (int begin = next.fetch_add(block); begin < count; begin = next.fetch_add(block))
+    {
+      work(begin, min(count, begin + block), t);
+    }
+  };
+  vector<thread> workers;
+  for (int t = 1; t < threads; t++)
+  {
+    workers.push_back(thread(body, t));
+  }
+  body(0); // this thread works too
+  for (size_t t = 0; t < workers.size(); t++)
+  {
+    workers[t].join();
+  }
+}
+
+// Name: SimilarityIndex() - Default Constructor
+// Desc: Builds an empty index
+// Preconditions: None
+// Postconditions: No shapes are indexed
+SimilarityIndex::SimilarityIndex() : m_first(1, 0), m_removedCount(0) {}
+
+// Name: Add(vector<double>&, vector<double>&)
+// Desc: Stores the stops of a route as unit vectors, with their box
+// Preconditions: north and west have the same size, at least one stop
+// Postconditions: Returns the shape's number
+int SimilarityIndex::Add(const vector<double> &north, const vector<double> &west)
+{
+  double low[3] = {2.0, 2.0, 2.0};
+  double high[3] = {-2.0, -2.0, -2.0};
+  for (size_t i = 0; i < north.size(); i++)
+  {
+    double latitude = north[i] * DEG_2_RAD;
+    double longitude = west[i] * DEG_2_RAD;
+    double point[3] = {cos(latitude) * cos(longitude), cos(latitude) * sin(longitude), sin(latitude)};
+    m_x.push_back(point[0]);
+    m_y.push_back(point[1]);
+    m_z.push_back(point[2]);
+    for (int axis = 0; axis < 3; axis++)
+    {
+      low[axis] = min(low[axis], point[axis]);
+      high[axis] = max(high[axis], point[axis]);
+    }
+  }
+  m_boxes.insert(m_boxes.end(), low, low + 3);
+  m_boxes.insert(m_boxes.end(), high, high + 3);
+  m_first.push_back(m_x.size());
+  m_removed.push_back(0);
+  return m_first.size() - 2;
+}
+
+// Name: Remove(int)
+// Desc: Leaves a shape out of every later search
+// Preconditions: shape is in [0, GetSize())
+// Postconditions: GetRemovedCount() counts the shape
+void SimilarityIndex::Remove(int shape)
+{
+  if (!m_removed[shape])
+  {
+    m_removed[shape] = 1;
+    m_removedCount++;
+  }
+}
+
+// Name: Compact()
+// Desc: Slides every kept shape's stops and box down over the removed
+//   ones, in place
+// Preconditions: None
+// Postconditions: Returns the new number of every old one (-1 for a
+//   removed shape)
+vector<int> SimilarityIndex::Compact()
+{
+  int size = GetSize();
+  vector<int> renumber(size, -1);
+  int kept = 0;
+  int point = 0;
+  for (int shape = 0; shape < size; shape++)
+  {
+    if (m_removed[shape])
+    {
+      continue;
+    }
+    int first = m_first[shape];
+    int end = m_first[shape + 1];
+    m_first[kept] = point; // never ahead of first, so nothing unread is overwritten
+    for (int i = first; i < end; i++, point++)
+    {
+      m_x[point] = m_x[i];
+      m_y[point] = m_y[i];
+      m_z[point] = m_z[i];
+    }
+    for (int j = 0; j < 6; j++)
+    {
+      m_boxes[6 * kept + j] = m_boxes[6 * shape + j];
+    }
+    renumber[shape] = kept++;
+  }
+  m_first[kept] = point;
+  m_first.resize(kept + 1);
+  m_x.resize(point);
+  m_y.resize(point);
+  m_z.resize(point);
+  m_boxes.resize(6 * kept);
+  m_removed.assign(kept, 0);
+  m_removedCount = 0;
+  return renumber;
+}
+
+// Name: Clear()
+// Desc: Forgets every shape
+// Preconditions: None
+// Postconditions: GetSize() is 0
+void SimilarityIndex::Clear()
+{
+  m_first.assign(1, 0);
+  m_x.clear();
+  m_y.clear();
+  m_z.clear();
+  m_boxes.clear();
+  m_removed.clear();
+  m_removedCount = 0;
+}
+
+// Name: Similar(vector<double>&, vector<double>&, SimilarOptions)
+// Desc: Bounds every shape from its endpoints and box, refines the
+//   shapes with the smallest bounds, then every other shape that can
+//   still beat the matches kept
+// Preconditions: north and west have the same size, at least one stop
+// Postconditions: Returns at most m_count matches, nearest first
+vector<SimilarMatch> SimilarityIndex::Similar(const vector<double> &north, const vector<double> &west,
+                                              SimilarOptions options)
+{
+  vector<SimilarMatch> matches;
+  int size = GetSize();
+  if (size == m_removedCount || options.m_count < 1 || north.empty())
+  {
+    return matches;
+  }
+  SimilarityIndex query; // the query as a shape of its own, so both sides look alike
+  query.Add(north, west);
+  Shape route = query.GetShape(0);
+  int threads = max(1, options.m_threads);
+  const double NEVER = numeric_limits<double>::infinity();
+  double limit = (options.m_maxMiles > 0.0) ? options.m_maxMiles : NEVER;
+  int first = max(REFINE_FIRST, 4 * options.m_count);
+
+  // Filter: a lower bound for every shape, every thread keeping the
+  // first smallest bounds it saw (largest on top of a heap)
+  typedef pair<double, int> Bounded;
+  vector<double> lower(size);
+  int boundThreads = min(threads, 1 + size / BOUND_BLOCK);
+  vector<vector<Bounded> > smallest(boundThreads);
+  Share(size, BOUND_BLOCK, boundThreads, [&](int begin, int end, int t) {
+    vector<Bounded> &seeds = smallest[t];
+    for (int i = begin; i < end; i++)
+    {
+      if (m_removed[i])
+      {
+        lower[i] = -1.0; // no bound is negative, so the scan knows to skip it
+        continue;
+      }
+      lower[i] = LowerBound(route, GetShape(i), options.m_measure);
+      if (lower[i] > limit || i == options.m_exclude)
+      {
+        continue;
+      }
+      Bounded entry(lower[i], i);
+      if (static_cast<int>(seeds.size()) < first)
+      {
+        seeds.push_back(entry);
+        push_heap(seeds.begin(), seeds.end());
+      }
+      else if (entry < seeds.front())
+      {
+        pop_heap(seeds.begin(), seeds.end());
+        seeds.back() = entry;
+        push_heap(seeds.begin(), seeds.end());
+      }
+    }
+  });
+  vector<Bounded> seeds;
+  for (int t = 0; t < boundThreads; t++)
+  {
+    seeds.insert(seeds.end(), smallest[t].begin(), smallest[t].end());
+  }
+  sort(seeds.begin(), seeds.end());
+  if (static_cast<int>(seeds.size()) > first)
+  {
+    seeds.resize(first);
+  }
+  if (options.m_exclude >= 0 && options.m_exclude < size)
+  {
+    lower[options.m_exclude] = -1.0; // skipped like a removed shape
+  }
+
+  // Refine: every thread keeps its own best matches (worst on top of a
+  // heap). Once it has m_count of them its worst is an upper bound on
+  // the final worst, so it can lower the shared bound every thread
+  // prunes with
+  atomic<double> bound(limit);
+  vector<vector<SimilarMatch> > best(threads);
+  auto refine = [&](int shape, int t, vector<double> &rows) {
+    double current = bound.load(memory_order_relaxed);
+    if (lower[shape] > current)
+    {
+      return;
+    }
+    vector<SimilarMatch> &kept = best[t];
+    SimilarMatch match = {shape, Distance(route, GetShape(shape), options.m_measure, current, rows)};
+    if (match.m_miles > current)
+    {
+      return;
+    }
+    if (static_cast<int>(kept.size()) < options.m_count)
+    {
+      kept.push_back(match);
+      push_heap(kept.begin(), kept.end(), BetterMatch);
+    }
+    else if (BetterMatch(match, kept.front()))
+    {
+      pop_heap(kept.begin(), kept.end(), BetterMatch);
+      kept.back() = match;
+      push_heap(kept.begin(), kept.end(), BetterMatch);
+    }
+    if (static_cast<int>(kept.size()) == options.m_count)
+    {
+      double worst = kept.front().m_miles;
+      while (worst < current && !bound.compare_exchange_weak(current, worst))
+      {
+      }
+    }
+  };
+  // The smallest bounds first, so the shared bound drops quickly
+  Share(seeds.size(), REFINE_BLOCK, min(threads, 1 + static_cast<int>(seeds.size()) / REFINE_BLOCK),
+        [&](int begin, int end, int t) {
+          vector<double> rows;
+          for (int s = begin; s < end; s++)
+          {
+            refine(seeds[s].second, t, rows);
+            lower[seeds[s].second] = -1.0; // refined, so the scan skips it
+          }
+        });
+  // Then every other shape the bound has not ruled out
+  Share(size, REFINE_BLOCK * 16, min(threads, 1 + size / (REFINE_BLOCK * 16)), [&](int begin, int end, int t) {
+    vector<double> rows;
+    for (int i = begin; i < end; i++)
+    {
+      if (lower[i] >= 0.0)
+      {
+        refine(i, t, rows);
+      }
+    }
+  });
+
+  for (int t = 0; t < threads; t++)
+  {
+    matches.insert(matches.end(), best[t].begin(), best[t].end());
+  }
+  sort(matches.begin(), matches.end(), BetterMatch);
+  if (static_cast<int>(matches.size()) > options.m_count)
+  {
+    matches.resize(options.m_count);
+  }
+  return matches;
+}
+
+// Name: GetSize() / GetPointCount() / GetRemovedCount()
+// Desc: Return the number of shapes and of stops over all of them
+//   (removed ones included until Compact), and of removed shapes
+// Preconditions: None
+// Postconditions: Returns the count
+int SimilarityIndex::GetSize()
+{
+  return m_first.size() - 1;
+}
+
+int SimilarityIndex::GetPointCount()
+{
+  return m_x.size();
+}
+
+int SimilarityIndex::GetRemovedCount()
+{
+  return m_removedCount;
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the stop and box arrays
+// Preconditions: None
+// Postconditions: usage includes the index
+void SimilarityIndex::AddMemory(MemoryUsage &usage)
+{
+  AddVector(usage, m_first);
+  AddVector(usage, m_x);
+  AddVector(usage, m_y);
+  AddVector(usage, m_z);
+  AddVector(usage, m_boxes);
+  AddVector(usage, m_removed);
+}
+
+// Name: GetShape(int)
+// Desc: Returns a stored shape
+// Preconditions: shape is in [0, GetSize())
+// Postconditions: The pointers are valid until the next Add or Clear
+SimilarityIndex::Shape SimilarityIndex::GetShape(int shape)
+{
+  Shape result;
+  int first = m_first[shape];
+  result.m_x = m_x.data() + first;
+  result.m_y = m_y.data() + first;
+  result.m_z = m_z.data() + first;
+  result.m_size = m_first[shape + 1] - first;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    result.m_low[axis] = m_boxes[6 * shape + axis];
+    result.m_high[axis] = m_boxes[6 * shape + 3 + axis];
+  }
+  return result;
+}
+
+// Name: LowerBound(Shape&, Shape&, SimilarMeasure)
+// Desc: Miles the two shapes are at least apart, from the endpoints
+//   and the boxes only. A great circle is never shorter than the radius
+//   times the chord, which saves an asin per shape
+// Preconditions: Both shapes have stops
+// Postconditions: Returns a bound never above Distance
+double SimilarityIndex::LowerBound(const Shape &query, const Shape &shape, SimilarMeasure measure)
+{
+  int last = query.m_size - 1;
+  int shapeLast = shape.m_size - 1;
+  double start = (query.m_x[0] - shape.m_x[0]) * (query.m_x[0] - shape.m_x[0]) +
+                 (query.m_y[0] - shape.m_y[0]) * (query.m_y[0] - shape.m_y[0]) +
+                 (query.m_z[0] - shape.m_z[0]) * (query.m_z[0] - shape.m_z[0]);
+  double end = (query.m_x[last] - shape.m_x[shapeLast]) * (query.m_x[last] - shape.m_x[shapeLast]) +
+               (query.m_y[last] - shape.m_y[shapeLast]) * (query.m_y[last] - shape.m_y[shapeLast]) +
+               (query.m_z[last] - shape.m_z[shapeLast]) * (query.m_z[last] - shape.m_z[shapeLast]);
+  double gap = 0.0; // every pair of stops is at least this far apart (squared chords, like start and end)
+  for (int axis = 0; axis < 3; axis++)
+  {
+    double apart = max(0.0, max(query.m_low[axis] - shape.m_high[axis], shape.m_low[axis] - query.m_high[axis]));
+    gap += apart * apart;
+  }
+
+  if (measure == SIMILAR_FRECHET)
+  {
+    return double(EARTH_RADIUS) * sqrt(max(gap, max(start, end)));
+  }
+  // The walk pairs the two starts and the two ends (one pair when both
+  // routes are a single stop) and takes at least the longer route's
+  // number of steps
+  double ends = (last > 0 || shapeLast > 0) ? sqrt(start) + sqrt(end) : sqrt(start);
+  return double(EARTH_RADIUS) * max(ends, sqrt(gap) * max(query.m_size, shape.m_size));
+}
+
+// Name: Distance(Shape&, Shape&, SimilarMeasure, double, vector<double>&)
+// Desc: The distance by dynamic program over pairs of stops, one row
+//   at a time. A walk's value never drops from one row to the next, so
+//   once every cell of a row is over bound the answer is too
+// Preconditions: Both shapes have stops
+// Postconditions: Returns the miles, or a value above bound once it
+//   is certain to be above bound
+double SimilarityIndex::Distance(const Shape &query, const Shape &shape, SimilarMeasure measure, double bound,
+                                 vector<double> &rows)
+{
+  const double NEVER = numeric_limits<double>::infinity();
+  bool frechet = (measure == SIMILAR_FRECHET);
+  // Frechet compares squared chords (same order as miles, no asin per
+  // pair), dynamic time warping adds up miles
+  double stop = bound;
+  if (frechet)
+  {
+    double chord = (bound >= PI * EARTH_RADIUS) ? 2.0 : 2.0 * sin(bound / (2.0 * EARTH_RADIUS));
+    stop = (bound == NEVER) ? NEVER : chord * chord;
+  }
+  int columns = shape.m_size;
+  rows.resize(2 * columns);
+  double *previous = rows.data();
+  double *current = rows.data() + columns;
+  for (int i = 0; i < query.m_size; i++)
+  {
+    double smallest = NEVER;
+    for (int j = 0; j < columns; j++)
+    {
+      double dx = query.m_x[i] - shape.m_x[j];
+      double dy = query.m_y[i] - shape.m_y[j];
+      double dz = query.m_z[i] - shape.m_z[j];
+      double cost = dx * dx + dy * dy + dz * dz;
+      if (!frechet)
+      {
+        cost = ChordMiles(sqrt(cost));
+      }
+      double before = NEVER; // best walk reaching a neighbouring pair
+      if (i == 0 && j == 0)
+      {
+        before = 0.0;
+      }
+      if (i > 0)
+      {
+        before = min(before, previous[j]);
+      }
+      if (i > 0 && j > 0)
+      {
+        before = min(before, previous[j - 1]);
+      }
+      if (j > 0)
+      {
+        before = min(before, current[j - 1]);
+      }
+      current[j] = frechet ? max(before, cost) : before + cost;
+      smallest = min(smallest, current[j]);
+    }
+    if (smallest > stop)
+    {
+      return NEVER;
+    }
+    swap(previous, current);
+  }
+  double result = previous[columns - 1];
+  return frechet ? ChordMiles(sqrt(result)) : result;
+}
@@ -0,0 +1,130 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include "Memory.h"
+
+#include <vector>
+using namespace std;
+
+const int SIMILAR_LIMIT = 10; // Similar routes listed when a count is not given
+
+// How the distance between two routes is measured, both in miles
+enum SimilarMeasure {
+  SIMILAR_FRECHET, //Discrete Frechet: the longest gap while walking both routes in order
+  SIMILAR_DTW      //Dynamic time warping: the total of the gaps along the best walk
+};
+
+// What a similarity search looks for
+struct SimilarOptions {
+  int m_threads;            //Worker threads for the refinement
+  int m_count;              //Most matches returned
+  SimilarMeasure m_measure; //Distance between routes
+  double m_maxMiles;        //Matches further than this are dropped (0 for no limit)
+  int m_exclude;            //Shape left out (the query's own, -1 for none)
+};
+
+// One shape found by a similarity search
+struct SimilarMatch {
+  int m_shape; //Number Add returned
+  double m_miles;
+};
+
+class SimilarityIndex {
+ public:
+  // Name: SimilarityIndex() - Default Constructor
+  // Desc: Builds an empty index
+  // Preconditions: None
+  // Postconditions: No shapes are indexed
+  SimilarityIndex();
+  // Name: Add(vector<double>&, vector<double>&)
+  // Desc: Stores the stops of a route (degrees) as unit vectors, with
+  //   the box around them
+  // Preconditions: north and west have the same size, at least one stop
+  // Postconditions: Returns the shape's number (the count before it)
+  int Add(const vector<double> &north, const vector<double> &west);
+  // Name: Remove(int)
+  // Desc: Leaves a shape out of every later search. Its stops stay
+  //   until Compact, so the other shapes keep their numbers
+  // Preconditions: shape is in [0, GetSize())
+  // Postconditions: GetRemovedCount() counts the shape
+  void Remove(int shape);
+  // Name: Compact()
+  // Desc: Drops the stops of every removed shape and numbers the rest
+  //   again in the same order
+  // Preconditions: None
+  // Postconditions: Returns the new number of every old one (-1 for a
+  //   removed shape); GetRemovedCount() is 0
+  vector<int> Compact();
+  // Name: Clear()
+  // Desc: Forgets every shape
+  // Preconditions: None
+  // Postconditions: GetSize() is 0
+  void Clear();
+  // Name: Similar(vector<double>&, vector<double>&, SimilarOptions)
+  // Desc: Finds the shapes nearest a route. Filter, then refine:
+  //   every shape gets a cheap lower bound on its distance from its
+  //   endpoints (both routes start and end matched to each other) and
+  //   from the gap between the boxes around the two routes (every stop
+  //   is matched to some stop of the other route). The shapes with the
+  //   smallest bounds are refined first so the bound of the worst match
+  //   kept drops quickly, then every shape whose lower bound is still
+  //   under it is refined, abandoning the dynamic program once a whole
+  //   row is over it. Refinement is shared out over the threads, each
+  //   keeping its own best matches and tightening one shared bound
+  // Preconditions: north and west have the same size, at least one stop
+  // Postconditions: Returns at most m_count matches, nearest first
+  //   (ties by shape number), never a removed shape
+  vector<SimilarMatch> Similar(const vector<double> &north, const vector<double> &west, SimilarOptions options);
+  // Name: GetSize() / GetPointCount() / GetRemovedCount()
+  // Desc: Return the number of shapes and of stops over all of them
+  //   (removed ones included until Compact), and of removed shapes
+  // Preconditions: None
+  // Postconditions: Returns the count
+  int GetSize();
+  int GetPointCount();
+  int GetRemovedCount();
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the stop and box arrays
+  // Preconditions: None
+  // Postconditions: usage includes the index
+  void AddMemory(MemoryUsage &usage);
+ private:
+  // A route as unit vectors, with its box
+  struct Shape {
+    const double *m_x;
+    const double *m_y;
+    const double *m_z;
+    int m_size;
+    double m_low[3];
+    double m_high[3];
+  };
+  // Name: GetShape(int)
+  // Desc: Returns a stored shape
+  // Preconditions: shape is in [0, GetSize())
+  // Postconditions: The pointers are valid until the next Add or Clear
+  Shape GetShape(int shape);
+  // Name: LowerBound(Shape&, Shape&, SimilarMeasure)
+  // Desc: Miles the two shapes are at least apart, from the endpoints
+  //   and the boxes only
+  // Preconditions: Both shapes have stops
+  // Postconditions: Returns a bound never above Distance
+  static double LowerBound(const Shape &query, const Shape &shape, SimilarMeasure measure);
+  // Name: Distance(Shape&, Shape&, SimilarMeasure, double, vector<double>&)
+  // Desc: The distance by dynamic program over pairs of stops, one row
+  //   at a time in rows (two rows of the other shape's size)
+  // Preconditions: Both shapes have stops
+  // Postconditions: Returns the miles, or a value above bound once it
+  //   is certain to be above bound
+  static double Distance(const Shape &query, const Shape &shape, SimilarMeasure measure, double bound,
+                         vector<double> &rows);
+
+  vector<int> m_first;   //Index of every shape's first stop, one past the end last
+  vector<double> m_x;    //Unit vector of every stop, shape after shape
+  vector<double> m_y;
+  vector<double> m_z;
+  vector<double> m_boxes; //Low x, y, z then high x, y, z of every shape
+  vector<char> m_removed; //1 for every shape left out by Remove
+  int m_removedCount;     //Shapes removed since the last Compact
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*****************************************
+** File:    SymbolTable.cpp
+** Description: This file implements the string interning pool for catalog text
+***********************************************/
+
+#include "SymbolTable.h"
+
+#include <stdexcept>
+using namespace std;
+
+// Name: SymbolTable() - Default Constructor
+// Desc: Builds a table holding only the empty string
+// Preconditions: None
+// Postconditions: SYMBOL_EMPTY is interned
+SymbolTable::SymbolTable() : m_size(0)
+{
+  for (int i = 0; i < SYMBOL_CHUNKS; i++)
+  {
+    m_chunks[i] = nullptr;
+  }
+  Intern(""); // becomes SYMBOL_EMPTY
+}
+
+// Name: ~SymbolTable() - Destructor
+// Desc: Frees every chunk
+// Preconditions: No Symbol of the table is used afterwards
+// Postconditions: Table is deallocated
+SymbolTable::~SymbolTable()
+{
+  for (int i = 0; i < SYMBOL_CHUNKS; i++)
+  {
+    delete[] m_chunks[i].load();
+  }
+}
+
+// Name: Shared()
+// Desc: Returns the table every Airport interns its text in. Strings
+//   are never freed, so it holds every distinct text loaded since start
+// Preconditions: None
+// Postconditions: Returns the process wide table
+SymbolTable &SymbolTable::Shared()
+{
+  static SymbolTable table; // built on first use, thread safe
+  return table;
+}
+
+// Name: Intern(string_view)
+// Desc: Returns the id of a string, storing it the first time it is seen
+// Preconditions: None
+// Postconditions: Returns the string's Symbol. Throws length_error
+//   if the string is new and the table is full
+Symbol SymbolTable::Intern(string_view text)
+{
+  lock_guard<mutex> hold(m_lock);
+  auto found = m_find.find(text);
+  if (found != m_find.end())
+  {
+    return found->second;
+  }
+  if (m_size >= (SYMBOL_CHUNKS << SYMBOL_CHUNK_BITS))
+  {
+    throw length_error("SymbolTable: too many strings");
+  }
+  Symbol symbol = m_size;
+  int chunk = symbol >> SYMBOL_CHUNK_BITS;
+  string *strings = m_chunks[chunk].load(memory_order_relaxed);
+  if (strings == nullptr)
+  {
+    strings = new string[1 << SYMBOL_CHUNK_BITS];
+  }
+  string &stored = strings[symbol & ((1 << SYMBOL_CHUNK_BITS) - 1)];
+  stored.assign(text.data(), text.size());
+  m_chunks[chunk].store(strings, memory_order_release); // publishes the string too
+  m_find[string_view(stored)] = symbol; // the key views the stored copy
+  m_size = symbol + 1;
+  return symbol;
+}
+
+// Name: GetSize()
+// Desc: Returns the number of distinct strings interned
+// Preconditions: None
+// Postconditions: Returns m_size
+int SymbolTable::GetSize()
+{
+  return m_size;
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the chunks, the strings and the lookup table
+// Preconditions: None
+// Postconditions: usage includes the table
+void SymbolTable::AddMemory(MemoryUsage &usage)
+{
+  lock_guard<mutex> hold(m_lock);
+  int size = m_size;
+  for (int chunk = 0; chunk <= (size - 1) >> SYMBOL_CHUNK_BITS; chunk++)
+  {
+    AddBlock(usage, sizeof(string) << SYMBOL_CHUNK_BITS);
+  }
+  for (Symbol symbol = 0; symbol < size; symbol++)
+  {
+    AddString(usage, Text(symbol));
+  }
+  AddHashMap(usage, m_find);
+}
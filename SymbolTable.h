@@ -0,0 +1,86 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include "Memory.h"
+
+#include <string>
+#include <string_view>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+using namespace std;
+
+typedef int Symbol; // Id of an interned string, equal ids mean equal text
+
+const int SYMBOL_CHUNK_BITS = 12; // Strings per chunk is 1 << SYMBOL_CHUNK_BITS
+const int SYMBOL_CHUNKS = 16384;  // Chunks a table can hold (67 million strings, see Intern)
+const Symbol SYMBOL_EMPTY = 0;    // The empty string, interned by every table
+
+class SymbolTable {
+ public:
+  // Name: SymbolTable() - Default Constructor
+  // Desc: Builds a table holding only the empty string
+  // Preconditions: None
+  // Postconditions: SYMBOL_EMPTY is interned
+  SymbolTable();
+  // Name: ~SymbolTable() - Destructor
+  // Desc: Frees every chunk
+  // Preconditions: No Symbol of the table is used afterwards
+  // Postconditions: Table is deallocated
+  ~SymbolTable();
+  // Name: Shared()
+  // Desc: Returns the table every Airport interns its text in. Catalog
+  //   snapshots share it, so a reload finds its strings already there.
+  //   Strings are never freed (stored routes keep copies of airports
+  //   from old snapshots), so the table holds every distinct name, city
+  //   and country loaded since start: a reload that edits a name adds
+  //   the new one and keeps the old. Memory grows with the text ever
+  //   edited, not with the number of reloads, up to the limit of Intern
+  // Preconditions: None
+  // Postconditions: Returns the process wide table
+  static SymbolTable &Shared();
+  // Name: Intern(string_view)
+  // Desc: Returns the id of a string, storing it the first time it is
+  //   seen. Stored strings never move or go away
+  // Preconditions: None
+  // Postconditions: Returns the string's Symbol. Throws length_error
+  //   if the string is new and SYMBOL_CHUNKS << SYMBOL_CHUNK_BITS
+  //   strings are stored already
+  Symbol Intern(string_view text);
+  // Name: Text(Symbol)
+  // Desc: Returns the string of an id without locking or copying
+  // Preconditions: symbol came from Intern on this table
+  // Postconditions: Returns a reference valid for the table's lifetime
+  const string &Text(Symbol symbol) const
+  {
+    return m_chunks[symbol >> SYMBOL_CHUNK_BITS].load(memory_order_acquire)[symbol & ((1 << SYMBOL_CHUNK_BITS) - 1)];
+  }
+  // Name: View(Symbol)
+  // Desc: Returns the string of an id as a view
+  // Preconditions: symbol came from Intern on this table
+  // Postconditions: Returns a view valid for the table's lifetime
+  string_view View(Symbol symbol) const
+  {
+    return Text(symbol);
+  }
+  // Name: GetSize()
+  // Desc: Returns the number of distinct strings interned
+  // Preconditions: None
+  // Postconditions: Returns m_size
+  int GetSize();
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the chunks, the strings and the lookup table
+  // Preconditions: None
+  // Postconditions: usage includes the table
+  void AddMemory(MemoryUsage &usage);
+ private:
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  mutex m_lock; //Guards m_find and adding strings
+  unordered_map<string_view, Symbol> m_find; //Text (viewing the stored string) to its id
+  atomic<string *> m_chunks[SYMBOL_CHUNKS]; //Stored strings, allocated a chunk at a time
+  atomic<int> m_size; //Strings stored
+};
+
+#endif
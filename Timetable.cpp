@@ -0,0 +1,397 @@
+/*****************************************
+** File:    Timetable.cpp
+** Description: This file implements the flight timetable and its Connection Scan queries
+***********************************************/
+
+#include "Timetable.h"
+#include <algorithm>
+#include <sstream>
+#include <cstdio>
+#include <cctype>
+using namespace std;
+
+// Name: Timetable() - Default Constructor
+// Desc: Builds an empty timetable
+// Preconditions: None
+// Postconditions: No airports or connections, no connection times
+Timetable::Timetable() : m_defaultConnect(0), m_badLines(0) {}
+
+// Name: Load(istream&)
+// Desc: Reads a timetable of flights and minimum connection times, then
+//   sorts the flights by departure into one array
+// Preconditions: Timetable is empty
+// Postconditions: Returns true if any flight was read. Bad lines are
+//   counted (GetBadLines) and skipped
+bool Timetable::Load(istream &input)
+{
+  unordered_map<string, int> connectTimes; // MCT lines may come before the airport's flights
+  string line;
+  while (getline(input, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    vector<string> fields;
+    stringstream ss(line);
+    string field;
+    while (getline(ss, field, ','))
+    {
+      fields.push_back(field);
+    }
+
+    if (fields.size() == 3 && fields[0] == "MCT")
+    {
+      int minutes = ParseTime(fields[2]);
+      if (minutes < 0)
+      {
+        m_badLines++;
+      }
+      else if (fields[1] == "*")
+      {
+        m_defaultConnect = minutes;
+      }
+      else
+      {
+        connectTimes[fields[1]] = minutes;
+      }
+      continue;
+    }
+    if (fields.size() != 4 || fields[0].empty() || fields[1].empty() || fields[0] == fields[1])
+    {
+      m_badLines++;
+      continue;
+    }
+    Connection connection;
+    connection.m_departure = ParseTime(fields[2]);
+    connection.m_arrival = ParseTime(fields[3]);
+    if (connection.m_departure < 0 || connection.m_arrival < connection.m_departure)
+    {
+      m_badLines++; // arriving before leaving is a typo, not a flight
+      continue;
+    }
+    connection.m_from = AirportFor(fields[0]);
+    connection.m_to = AirportFor(fields[1]);
+    m_connections.push_back(connection);
+  }
+
+  sort(m_connections.begin(), m_connections.end(), [](const Connection &first, const Connection &second) {
+    return first.m_departure != second.m_departure ? first.m_departure < second.m_departure
+                                                   : first.m_arrival < second.m_arrival;
+  });
+  m_connections.shrink_to_fit();
+  m_minConnect.assign(m_codes.size(), m_defaultConnect);
+  for (auto entry = connectTimes.begin(); entry != connectTimes.end(); ++entry)
+  {
+    int airport = Find(entry->first);
+    if (airport >= 0)
+    {
+      m_minConnect[airport] = entry->second;
+    }
+  }
+  return !m_connections.empty();
+}
+
+// Name: EarliestArrival(string, string, int)
+// Desc: Connection Scan from departure, stopping once flights leave
+//   after the best arrival at the destination
+// Preconditions: None
+// Postconditions: Returns true and fills journey if the destination
+//   can be reached, false otherwise (unknown codes included)
+bool Timetable::EarliestArrival(string from, string to, int departure, Journey &journey)
+{
+  int origin = Find(from);
+  int destination = Find(to);
+  if (origin < 0 || destination < 0 || origin == destination)
+  {
+    return false;
+  }
+  int size = m_codes.size();
+  vector<int> arrival(size, TIME_NEVER);
+  vector<int> ready(size, TIME_NEVER); // earliest time a flight can be boarded
+  vector<int> inbound(size, -1);       // flight that gave the arrival
+  arrival[origin] = departure;
+  ready[origin] = departure; // no connection time before the first flight
+
+  Connection first = {0, 0, departure, 0};
+  auto start = lower_bound(m_connections.begin(), m_connections.end(), first,
+                           [](const Connection &a, const Connection &b) { return a.m_departure < b.m_departure; });
+  for (size_t i = start - m_connections.begin(); i < m_connections.size(); i++)
+  {
+    const Connection &connection = m_connections[i];
+    if (connection.m_departure >= arrival[destination])
+    {
+      break; // every later flight lands later still
+    }
+    if (ready[connection.m_from] <= connection.m_departure && connection.m_arrival < arrival[connection.m_to])
+    {
+      arrival[connection.m_to] = connection.m_arrival;
+      ready[connection.m_to] = connection.m_arrival + m_minConnect[connection.m_to];
+      inbound[connection.m_to] = i;
+    }
+  }
+  if (inbound[destination] < 0)
+  {
+    return false;
+  }
+
+  journey.m_connections.clear();
+  for (int at = destination; at != origin; at = m_connections[inbound[at]].m_from)
+  {
+    journey.m_connections.push_back(inbound[at]);
+  }
+  reverse(journey.m_connections.begin(), journey.m_connections.end());
+  journey.m_departure = m_connections[journey.m_connections.front()].m_departure;
+  journey.m_arrival = arrival[destination];
+  return true;
+}
+
+// Name: Profile(string, string, int, int)
+// Desc: Profile Connection Scan from the latest flight down to first
+// Preconditions: None
+// Postconditions: Returns every journey leaving the origin between
+//   first and last that no other journey beats, earliest departure first
+vector<Journey> Timetable::Profile(string from, string to, int first, int last)
+{
+  vector<Journey> journeys;
+  int origin = Find(from);
+  int destination = Find(to);
+  if (origin < 0 || destination < 0 || origin == destination)
+  {
+    return journeys;
+  }
+
+  // Entries of an airport are added latest departure first and each one
+  // arrives sooner than every entry before it. One leaving at the same
+  // time as the last goes after it instead of over it: entries of other
+  // airports may lead on to the last, and must keep their onward leg
+  struct Entry {
+    int m_departure;  //Leaving the airport
+    int m_arrival;    //At the destination
+    int m_connection; //First flight
+    int m_next;       //Entry taken at the flight's airport (-1 if it lands at the destination)
+  };
+  vector<vector<Entry> > profiles(m_codes.size());
+
+  Connection earliest = {0, 0, first, 0};
+  auto start = lower_bound(m_connections.begin(), m_connections.end(), earliest,
+                           [](const Connection &a, const Connection &b) { return a.m_departure < b.m_departure; });
+  int stop = start - m_connections.begin();
+  for (int i = m_connections.size() - 1; i >= stop; i--)
+  {
+    const Connection &connection = m_connections[i];
+    if (connection.m_from == destination)
+    {
+      continue;
+    }
+    Entry entry = {connection.m_departure, TIME_NEVER, i, -1};
+    if (connection.m_to == destination)
+    {
+      entry.m_arrival = connection.m_arrival;
+    }
+    else
+    {
+      // The soonest departure that can still be made after landing
+      // has the best arrival; departures run down, so search for the
+      // last entry leaving at or after ready
+      vector<Entry> &onward = profiles[connection.m_to];
+      int ready = connection.m_arrival + m_minConnect[connection.m_to];
+      int low = 0;
+      int high = onward.size();
+      while (low < high)
+      {
+        int middle = (low + high) / 2;
+        if (onward[middle].m_departure >= ready)
+        {
+          low = middle + 1;
+        }
+        else
+        {
+          high = middle;
+        }
+      }
+      if (low > 0)
+      {
+        entry.m_arrival = onward[low - 1].m_arrival;
+        entry.m_next = low - 1;
+      }
+    }
+    if (entry.m_arrival == TIME_NEVER)
+    {
+      continue;
+    }
+
+    vector<Entry> &here = profiles[connection.m_from];
+    if (!here.empty() && here.back().m_arrival <= entry.m_arrival)
+    {
+      continue; // leaving later gets there as soon
+    }
+    here.push_back(entry);
+  }
+
+  vector<Entry> &options = profiles[origin];
+  for (int i = options.size() - 1; i >= 0; i--)
+  {
+    if (options[i].m_departure > last)
+    {
+      break;
+    }
+    if (i + 1 < static_cast<int>(options.size()) && options[i + 1].m_departure == options[i].m_departure)
+    {
+      continue; // the entry after it leaves as late and arrives sooner
+    }
+    Journey journey;
+    journey.m_departure = options[i].m_departure;
+    journey.m_arrival = options[i].m_arrival;
+    const Entry *entry = &options[i];
+    while (true)
+    {
+      journey.m_connections.push_back(entry->m_connection);
+      if (entry->m_next < 0)
+      {
+        break;
+      }
+      entry = &profiles[m_connections[entry->m_connection].m_to][entry->m_next];
+    }
+    journeys.push_back(journey);
+  }
+  return journeys;
+}
+
+// Name: GetConnection(int)
+// Desc: Returns a flight of the sorted array
+// Preconditions: index is in [0, GetConnectionCount())
+// Postconditions: Returns the connection
+const Connection &Timetable::GetConnection(int index)
+{
+  return m_connections[index];
+}
+
+// Name: GetCode(int)
+// Desc: Returns the code of a timetable airport
+// Preconditions: airport is a timetable airport
+// Postconditions: Returns its code
+const string &Timetable::GetCode(int airport)
+{
+  return m_codes[airport];
+}
+
+// Name: GetConnectionCount() / GetAirportCount() / GetBadLines()
+// Desc: Return the sizes of the timetable and the lines Load skipped
+// Preconditions: None
+// Postconditions: Returns the count
+int Timetable::GetConnectionCount()
+{
+  return m_connections.size();
+}
+
+int Timetable::GetAirportCount()
+{
+  return m_codes.size();
+}
+
+int Timetable::GetBadLines()
+{
+  return m_badLines;
+}
+
+// Name: AddMemory(MemoryUsage&)
+// Desc: Counts the connection array and the airport tables
+// Preconditions: None
+// Postconditions: usage includes the timetable's heap
+void Timetable::AddMemory(MemoryUsage &usage)
+{
+  AddVector(usage, m_connections);
+  AddVector(usage, m_codes);
+  for (size_t i = 0; i < m_codes.size(); i++)
+  {
+    AddString(usage, m_codes[i]);
+  }
+  AddHashMap(usage, m_airports);
+  for (auto entry = m_airports.begin(); entry != m_airports.end(); ++entry)
+  {
+    AddString(usage, entry->first);
+  }
+  AddVector(usage, m_minConnect);
+}
+
+// Name: ParseTime(string)
+// Desc: Converts HH:MM[+N] (N days later) or plain minutes to minutes.
+//   Every part has at most 8 digits, so the sum is worked out in 64 bits
+//   and checked against TIME_MAX_DAYS before it is made an int
+// Preconditions: None
+// Postconditions: Returns -1 for text that is not a time or is more
+//   than TIME_MAX_DAYS days past day 0
+int Timetable::ParseTime(const string &text)
+{
+  const long long LATEST = (TIME_MAX_DAYS + 1) * 24LL * 60 - 1;
+  auto digits = [](const string &part) {
+    return !part.empty() && part.size() < 9 &&
+           all_of(part.begin(), part.end(), [](char c) { return isdigit(static_cast<unsigned char>(c)) != 0; });
+  };
+  size_t colon = text.find(':');
+  if (colon == string::npos)
+  {
+    return (digits(text) && stoll(text) <= LATEST) ? stoi(text) : -1;
+  }
+  size_t plus = text.find('+', colon);
+  string hours = text.substr(0, colon);
+  string minutes = text.substr(colon + 1, (plus == string::npos) ? string::npos : plus - colon - 1);
+  string days = (plus == string::npos) ? "0" : text.substr(plus + 1);
+  if (!digits(hours) || !digits(minutes) || !digits(days) || stoi(minutes) > 59 || stoi(days) > TIME_MAX_DAYS)
+  {
+    return -1;
+  }
+  long long total = (stoll(days) * 24 + stoll(hours)) * 60 + stoll(minutes);
+  return (total <= LATEST) ? static_cast<int>(total) : -1;
+}
+
+// Name: FormatTime(int)
+// Desc: Converts minutes to HH:MM, with +N for N days later
+// Preconditions: minutes >= 0
+// Postconditions: Returns the text
+string Timetable::FormatTime(int minutes)
+{
+  char text[32];
+  int days = minutes / (24 * 60);
+  minutes %= 24 * 60;
+  if (days > 0)
+  {
+    snprintf(text, sizeof(text), "%02d:%02d+%d", minutes / 60, minutes % 60, days);
+  }
+  else
+  {
+    snprintf(text, sizeof(text), "%02d:%02d", minutes / 60, minutes % 60);
+  }
+  return text;
+}
+
+// Name: AirportFor(string)
+// Desc: Returns the timetable airport of a code, adding it if new
+// Preconditions: None
+// Postconditions: Returns an index into m_codes
+int Timetable::AirportFor(const string &code)
+{
+  auto found = m_airports.find(code);
+  if (found != m_airports.end())
+  {
+    return found->second;
+  }
+  m_codes.push_back(code);
+  m_airports[code] = m_codes.size() - 1;
+  return m_codes.size() - 1;
+}
+
+// Name: Find(string)
+// Desc: Returns the timetable airport of a code
+// Preconditions: None
+// Postconditions: Returns -1 for a code with no flights
+int Timetable::Find(const string &code)
+{
+  auto found = m_airports.find(code);
+  return (found == m_airports.end()) ? -1 : found->second;
+}
@@ -0,0 +1,123 @@
+#ifndef TIMETABLE_H
+#define TIMETABLE_H
+
+#include "Memory.h"
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <climits>
+#include <unordered_map>
+using namespace std;
+
+const int TIME_NEVER = INT_MAX; // Arrival time of an airport that cannot be reached
+const int TIME_MAX_DAYS = 366;  // Most days a time can be past day 0, so minutes never near overflow
+
+// One scheduled flight. Times are minutes from the start of day 0 of
+// the timetable, so a flight past midnight simply has a larger arrival
+struct Connection {
+  int m_from;      //Timetable airport the flight leaves
+  int m_to;        //Timetable airport it lands at
+  int m_departure; //Minutes
+  int m_arrival;   //Minutes
+};
+
+// A trip through the timetable, first flight first
+struct Journey {
+  vector<int> m_connections; //Indexes into the connection array
+  int m_departure;           //Departure of the first flight
+  int m_arrival;             //Arrival of the last flight
+};
+
+class Timetable {
+ public:
+  // Name: Timetable() - Default Constructor
+  // Desc: Builds an empty timetable
+  // Preconditions: None
+  // Postconditions: No airports or connections, no connection times
+  Timetable();
+  // Name: Load(istream&)
+  // Desc: Reads a timetable, one line each:
+  //     ORIGIN,DESTINATION,DEPARTURE,ARRIVAL  a flight
+  //     MCT,CODE,MINUTES                      minimum connection time at an airport
+  //     MCT,*,MINUTES                         the same for every other airport
+  //   Times are HH:MM with an optional +N for N days later, N up to
+  //   TIME_MAX_DAYS (or plain minutes). Blank lines and lines starting
+  //   with # are skipped.
+  //   The flights are then sorted by departure into one array
+  // Preconditions: Timetable is empty
+  // Postconditions: Returns true if any flight was read. Bad lines are
+  //   counted (GetBadLines) and skipped
+  bool Load(istream &input);
+  // Name: EarliestArrival(string, string, int)
+  // Desc: Connection Scan: one pass over the flights leaving at or after
+  //   departure, stopping once flights leave after the best arrival at
+  //   the destination. A flight can be taken from an airport once the
+  //   minimum connection time has passed since landing there (not at
+  //   the origin)
+  // Preconditions: None
+  // Postconditions: Returns true and fills journey if the destination
+  //   can be reached, false otherwise (unknown codes included)
+  bool EarliestArrival(string from, string to, int departure, Journey &journey);
+  // Name: Profile(string, string, int, int)
+  // Desc: Profile Connection Scan: one pass over the flights from the
+  //   latest down to first, keeping for every airport the departures that
+  //   reach the destination sooner than any later departure does
+  //   (an entry is never replaced, since entries at other airports may
+  //   lead on to it; a better one leaving at the same time goes after
+  //   it and the worse one is dropped when the journeys are listed)
+  // Preconditions: None
+  // Postconditions: Returns every journey leaving the origin between
+  //   first and last that no other journey beats (leaves no earlier
+  //   and arrives no later), earliest departure first
+  vector<Journey> Profile(string from, string to, int first, int last);
+  // Name: GetConnection(int)
+  // Desc: Returns a flight of the sorted array
+  // Preconditions: index is in [0, GetConnectionCount())
+  // Postconditions: Returns the connection
+  const Connection &GetConnection(int index);
+  // Name: GetCode(int)
+  // Desc: Returns the code of a timetable airport
+  // Preconditions: airport is a timetable airport
+  // Postconditions: Returns its code
+  const string &GetCode(int airport);
+  // Name: GetConnectionCount() / GetAirportCount() / GetBadLines()
+  // Desc: Return the sizes of the timetable and the lines Load skipped
+  // Preconditions: None
+  // Postconditions: Returns the count
+  int GetConnectionCount();
+  int GetAirportCount();
+  int GetBadLines();
+  // Name: AddMemory(MemoryUsage&)
+  // Desc: Counts the connection array and the airport tables
+  // Preconditions: None
+  // Postconditions: usage includes the timetable's heap
+  void AddMemory(MemoryUsage &usage);
+  // Name: ParseTime(string) / FormatTime(int)
+  // Desc: Convert between minutes and HH:MM[+N]
+  // Preconditions: None
+  // Postconditions: ParseTime returns -1 for text that is not a time
+  //   or is more than TIME_MAX_DAYS days past day 0
+  static int ParseTime(const string &text);
+  static string FormatTime(int minutes);
+ private:
+  // Name: AirportFor(string)
+  // Desc: Returns the timetable airport of a code, adding it if new
+  // Preconditions: None
+  // Postconditions: Returns an index into m_codes
+  int AirportFor(const string &code);
+  // Name: Find(string)
+  // Desc: Returns the timetable airport of a code
+  // Preconditions: None
+  // Postconditions: Returns -1 for a code with no flights
+  int Find(const string &code);
+
+  vector<Connection> m_connections; //Every flight, sorted by departure then arrival
+  vector<string> m_codes; //Code of every timetable airport
+  unordered_map<string, int> m_airports; //Code to timetable airport
+  vector<int> m_minConnect; //Minimum connection minutes of every airport
+  int m_defaultConnect; //Minutes for airports the file gives no time for
+  int m_badLines; //Lines Load skipped
+};
+
+#endif
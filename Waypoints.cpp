@@ -0,0 +1,184 @@
+/*****************************************
+** File:    Waypoints.cpp
+** Description: This file implements streaming of great circle waypoints along a route
+***********************************************/
+
+#include "Waypoints.h"
+#include "DistanceModel.h"
+using namespace std;
+
+// Name: ToVector(double, double, double[3])
+// Desc: Converts degrees North and West to a unit vector
+// Preconditions: None
+// Postconditions: result holds the unit vector
+static void ToVector(double north, double west, double result[3])
+{
+  double lat = north * DEG_2_RAD;
+  double lng = west * DEG_2_RAD;
+  result[0] = cos(lat) * cos(lng);
+  result[1] = cos(lat) * sin(lng);
+  result[2] = sin(lat);
+}
+
+// Name: WaypointStream(Route*, double)
+// Desc: Prepares to walk a route along great circles, with a point at
+//   every airport and every spacing miles along each leg in between
+// Preconditions: route outlives the stream and is not changed while
+//   it is walked, spacing is positive
+// Postconditions: Stream is positioned at the first airport
+WaypointStream::WaypointStream(Route *route, double spacing)
+    : m_from(route->GetData(0)), m_spacing(spacing), m_routeMiles(0.0), m_leg(0), m_step(0),
+      m_points(0), m_angle(0.0), m_legMiles(0.0)
+{
+  if (m_from != nullptr && m_from->GetNext() != nullptr)
+  {
+    StartLeg();
+  }
+}
+
+// Name: StartLeg()
+// Desc: Sets up the rotation for the leg that starts at m_from
+// Preconditions: m_from and m_from->GetNext() exist
+// Postconditions: m_points and the rotation vectors describe the leg
+void WaypointStream::StartLeg()
+{
+  Airport *to = m_from->GetNext();
+  double end[3];
+  ToVector(m_from->GetNorth(), m_from->GetWest(), m_start);
+  ToVector(to->GetNorth(), to->GetWest(), end);
+
+  // Same haversine as CalcDistance so the miles agree with RouteDistance
+  m_legMiles = Haversine::Miles(m_from->GetNorth(), m_from->GetWest(), to->GetNorth(), to->GetWest());
+
+  // Part of the end vector at right angles to the start gives the direction
+  double along = m_start[0] * end[0] + m_start[1] * end[1] + m_start[2] * end[2];
+  double length = 0.0;
+  for (int i = 0; i < 3; i++)
+  {
+    m_toward[i] = end[i] - along * m_start[i];
+    length += m_toward[i] * m_toward[i];
+  }
+  length = sqrt(length);
+  if (length < 1e-12)
+  {
+    // Same or opposite airports: any great circle through the start works,
+    // use the one through the pole (or the prime meridian at a pole)
+    double pole[3] = {0.0, 0.0, 1.0};
+    if (fabs(m_start[2]) > 0.999999)
+    {
+      pole[0] = 1.0;
+      pole[2] = 0.0;
+    }
+    along = m_start[2] * pole[2] + m_start[0] * pole[0];
+    length = 0.0;
+    for (int i = 0; i < 3; i++)
+    {
+      m_toward[i] = pole[i] - along * m_start[i];
+      length += m_toward[i] * m_toward[i];
+    }
+    length = sqrt(length);
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    m_toward[i] /= length;
+  }
+
+  m_angle = m_spacing / EARTH_RADIUS;
+  m_points = static_cast<int>(ceil(m_legMiles / m_spacing - 1e-9));
+  if (m_points < 1)
+  {
+    m_points = 1; // the leg start is always a point
+  }
+  m_step = 0;
+}
+
+// Name: Next(Waypoint*, int)
+// Desc: Fills a caller supplied buffer with the next waypoints. Points
+//   along a leg come from rotating the leg's start vector, so only one
+//   sin and cos are computed per block instead of per point
+// Preconditions: buffer holds at least capacity waypoints
+// Postconditions: Returns how many were written, 0 once the route ends
+int WaypointStream::Next(Waypoint *buffer, int capacity)
+{
+  int written = 0;
+  while (written < capacity && m_from != nullptr)
+  {
+    if (m_from->GetNext() == nullptr)
+    {
+      // Last airport of the route ends the stream
+      Waypoint &last = buffer[written++];
+      last.m_north = m_from->GetNorth();
+      last.m_west = m_from->GetWest();
+      last.m_miles = m_routeMiles;
+      last.m_leg = m_leg > 0 ? m_leg - 1 : 0;
+      m_from = nullptr;
+      break;
+    }
+
+    int count = min(min(capacity - written, m_points - m_step), WAYPOINT_BLOCK);
+
+    // Rotate by m_angle per point, starting exactly at this block's first
+    // point so rounding does not build up along long legs
+    double cosines[WAYPOINT_BLOCK];
+    double sines[WAYPOINT_BLOCK];
+    double stepCos = cos(m_angle);
+    double stepSin = sin(m_angle);
+    cosines[0] = cos(m_step * m_angle);
+    sines[0] = sin(m_step * m_angle);
+    for (int i = 1; i < count; i++)
+    {
+      cosines[i] = cosines[i - 1] * stepCos - sines[i - 1] * stepSin;
+      sines[i] = sines[i - 1] * stepCos + cosines[i - 1] * stepSin;
+    }
+
+    // Plain loops over arrays so the compiler can vectorize them
+    double x[WAYPOINT_BLOCK];
+    double y[WAYPOINT_BLOCK];
+    double z[WAYPOINT_BLOCK];
+    for (int i = 0; i < count; i++)
+    {
+      x[i] = cosines[i] * m_start[0] + sines[i] * m_toward[0];
+      y[i] = cosines[i] * m_start[1] + sines[i] * m_toward[1];
+      z[i] = cosines[i] * m_start[2] + sines[i] * m_toward[2];
+    }
+    for (int i = 0; i < count; i++)
+    {
+      Waypoint &point = buffer[written + i];
+      point.m_north = atan2(z[i], sqrt(x[i] * x[i] + y[i] * y[i])) * RAD_2_DEG;
+      point.m_west = atan2(y[i], x[i]) * RAD_2_DEG; // always in [-180, 180]
+      point.m_miles = m_routeMiles + (m_step + i) * m_spacing;
+      point.m_leg = m_leg;
+    }
+    written += count;
+    m_step += count;
+
+    if (m_step == m_points)
+    {
+      // Leg finished, the next leg starts at its end airport
+      m_routeMiles += m_legMiles;
+      m_from = m_from->GetNext();
+      m_leg++;
+      if (m_from->GetNext() != nullptr)
+      {
+        StartLeg();
+      }
+    }
+  }
+  return written;
+}
+
+// Name: StreamWaypoints(Route*, double, WaypointSink&)
+// Desc: Streams every waypoint of a route into a sink through one fixed
+//   buffer, so memory does not grow with the length of the route
+// Preconditions: spacing is positive
+// Postconditions: Every waypoint of the route was written to sink
+void StreamWaypoints(Route *route, double spacing, WaypointSink &sink)
+{
+  Waypoint buffer[WAYPOINT_BLOCK];
+  WaypointStream stream(route, spacing);
+  int count;
+  while ((count = stream.Next(buffer, WAYPOINT_BLOCK)) > 0)
+  {
+    sink.Write(buffer, count);
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef WAYPOINTS_H
+#define WAYPOINTS_H
+
+#include "Airport.h"
+#include "Route.h"
+using namespace std;
+
+const int WAYPOINT_BLOCK = 64; // Points produced per block (and buffer size of StreamWaypoints)
+
+// One point along a route. Coordinates use the same degrees North and
+// West convention as the airports and CalcDistance; West is kept in
+// [-180, 180] so legs across the 180th meridian wrap cleanly
+struct Waypoint {
+  double m_north; //Latitude in degrees
+  double m_west;  //Longitude in degrees
+  double m_miles; //Miles from the start of the route
+  int m_leg;      //Leg the point is on (0 is first airport to second)
+};
+
+// Receives waypoints in blocks of at most WAYPOINT_BLOCK points
+class WaypointSink {
+ public:
+  virtual ~WaypointSink() {}
+  // Name: Write(Waypoint*, int)
+  // Desc: Takes the next block of waypoints
+  // Preconditions: points holds count waypoints, valid only during the call
+  // Postconditions: Sink has consumed the block
+  virtual void Write(const Waypoint *points, int count) = 0;
+};
+
+class WaypointStream {
+ public:
+  // Name: WaypointStream(Route*, double)
+  // Desc: Prepares to walk a route along great circles, with a point at
+  //   every airport and every spacing miles along each leg in between
+  // Preconditions: route outlives the stream and is not changed while
+  //   it is walked, spacing is positive
+  // Postconditions: Stream is positioned at the first airport
+  WaypointStream(Route *route, double spacing);
+  // Name: Next(Waypoint*, int)
+  // Desc: Fills a caller supplied buffer with the next waypoints. Points
+  //   along a leg come from rotating the leg's start vector, so only one
+  //   sin and cos are computed per block instead of per point
+  // Preconditions: buffer holds at least capacity waypoints
+  // Postconditions: Returns how many were written, 0 once the route ends
+  int Next(Waypoint *buffer, int capacity);
+ private:
+  // Name: StartLeg()
+  // Desc: Sets up the rotation for the leg that starts at m_from
+  // Preconditions: m_from and m_from->GetNext() exist
+  // Postconditions: m_points and the rotation vectors describe the leg
+  void StartLeg();
+
+  Airport *m_from; //Airport the current leg starts at (nullptr when done)
+  double m_spacing; //Miles between waypoints
+  double m_routeMiles; //Miles of the legs already finished
+  int m_leg; //Current leg
+  int m_step; //Next point on the current leg (0 is the leg start)
+  int m_points; //Points on the current leg, not counting its end
+  double m_angle; //Angle between two points of the leg (radians)
+  double m_legMiles; //Length of the current leg
+  double m_start[3]; //Unit vector of the leg start
+  double m_toward[3]; //Unit vector 90 degrees from m_start toward the leg end
+};
+
+// Name: StreamWaypoints(Route*, double, WaypointSink&)
+// Desc: Streams every waypoint of a route into a sink through one fixed
+//   buffer, so memory does not grow with the length of the route
+// Preconditions: spacing is positive
+// Postconditions: Every waypoint of the route was written to sink
+void StreamWaypoints(Route *route, double spacing, WaypointSink &sink);
+
+#endif
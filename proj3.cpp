@@ -1,18 +1,120 @@
 #include "Navigator.h"
+#include "FeedStream.h"
 #include <iostream>
+#include <fstream>
+#include <cstdlib>
 using namespace std;
 
+// Name: StreamFeed
+// Desc: Runs a feed through the streaming pipeline without building a
+//   catalog. Options follow the file name and "-stream":
+//   country <name>, near <north> <west> <miles>, window <KB>, extract <file>
+//   A file name of "-" reads the feed from standard input
+// Preconditions: argv[1] is a feed file or "-", argv[2] is "-stream"
+// Postconditions: Prints the totals of the run
+static int StreamFeed(int argc, char* argv[]) {
+  FeedOptions options;
+  options.m_windowBytes = FEED_WINDOW_DEFAULT;
+  options.m_hasPoint = false;
+  options.m_north = 0.0;
+  options.m_west = 0.0;
+  options.m_miles = 0.0;
+  options.m_extract = nullptr;
+  ofstream extract;
+  for (int i = 3; i < argc; i++)
+    {
+      string option = argv[i];
+      if (option == "country" && i + 1 < argc)
+	{
+	  options.m_country = argv[++i];
+	}
+      else if (option == "near" && i + 3 < argc)
+	{
+	  options.m_hasPoint = true;
+	  options.m_north = atof(argv[++i]);
+	  options.m_west = atof(argv[++i]);
+	  options.m_miles = atof(argv[++i]);
+	}
+      else if (option == "window" && i + 1 < argc && atol(argv[i + 1]) > 0)
+	{
+	  options.m_windowBytes = atol(argv[++i]) * 1024;
+	}
+      else if (option == "extract" && i + 1 < argc)
+	{
+	  extract.open(argv[++i]);
+	  options.m_extract = &extract;
+	}
+      else
+	{
+	  cout << "Unknown stream option " << option << endl;
+	  return 1;
+	}
+    }
+
+  FeedTotals totals;
+  if (string(argv[1]) == "-")
+    {
+      totals = RunFeed(cin, options);
+    }
+  else
+    {
+      ifstream feed(argv[1]);
+      if (!feed.is_open())
+	{
+	  cout << "Could not open " << argv[1] << endl;
+	  return 1;
+	}
+      totals = RunFeed(feed, options);
+    }
+
+  cout << "Lines read: " << totals.m_read << endl;
+  cout << "Bad lines: " << totals.m_bad << endl;
+  cout << "Airports kept: " << totals.m_kept << endl;
+  if (options.m_hasPoint && totals.m_kept > 0)
+    {
+      cout << "Average miles: " << totals.m_totalMiles / totals.m_kept << endl;
+      cout << "Nearest: " << totals.m_nearestCode << " " << totals.m_nearestMiles << " miles" << endl;
+      cout << "Farthest: " << totals.m_farthestCode << " " << totals.m_farthestMiles << " miles" << endl;
+    }
+  cout << "Windows: " << totals.m_windows << " of " << options.m_windowBytes / 1024 << " KB" << endl;
+  cout << "Peak window memory: " << totals.m_peakBytes << " bytes" << endl;
+  return 0;
+}
+
 int main (int argc, char* argv[]) {
   if (argc < 2)
     {
       cout << "You are missing a data file." << endl;
       cout << "Expected usage ./proj3 proj3_data.txt" << endl;
       cout << "File 1 should be a file with airport data" << endl;
+      cout << "Add -batch to read commands from standard input" << endl;
+      cout << "Add -sessions script ... to run each command script as its own parallel session" << endl;
+      cout << "Add -shards N to split the catalog across N worker processes" << endl;
+      cout << "Add -stream to filter a huge feed in bounded memory (file - reads standard input)" << endl;
+    }
+  else if (argc > 3 && string(argv[2]) == "-sessions")
+    {
+      Navigator S(argv[1]);
+      S.StartSessions(vector<string>(argv + 3, argv + argc));
+    }
+  else if (argc > 3 && string(argv[2]) == "-shards")
+    {
+      Navigator S(argv[1]);
+      S.StartSharded(atoi(argv[3]));
+    }
+  else if (argc > 2 && string(argv[2]) == "-stream")
+    {
+      return StreamFeed(argc, argv);
+    }
+  else if (argc > 2 && string(argv[2]) == "-batch")
+    {
+      Navigator S(argv[1]);
+      S.StartBatch();
     }
   else
     {
       cout << endl << "***Navigator***" << endl << endl;
-      Navigator S = Navigator(argv[1]);
+      Navigator S(argv[1]);
       S.Start();
     }
   return 0;
@@ -0,0 +1,378 @@
+/*****************************************
+** File:    proj3_bench.cpp
+** Description: Benchmarks the catalog, leg graph and route code on a synthetic catalog
+***********************************************/
+
+#include "Navigator.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <unistd.h>
+using namespace std;
+
+static atomic<long> g_allocations(0); // operator new calls, to show which loops allocate
+
+void *operator new(size_t bytes)
+{
+  g_allocations++;
+  void *block = malloc(bytes == 0 ? 1 : bytes);
+  if (block == nullptr)
+  {
+    throw bad_alloc();
+  }
+  return block;
+}
+
+void operator delete(void *block) noexcept
+{
+  free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+  free(block);
+}
+
+// Name: Seconds
+// Desc: Returns the seconds since a start time
+// Preconditions: None
+// Postconditions: Returns elapsed seconds
+static double Seconds(chrono::steady_clock::time_point start)
+{
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Name: WriteCatalog
+// Desc: Writes a catalog of airports spread evenly between 60S and 60N.
+//   Coordinates have three decimals like the real data file
+// Preconditions: None
+// Postconditions: fileName holds count airports
+static void WriteCatalog(string fileName, int count)
+{
+  ofstream file(fileName);
+  unsigned long long seed = 12345; // fixed so every run measures the same catalog
+  for (int i = 0; i < count; i++)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    double north = ((seed >> 33) % 120000) / 1000.0 - 60.0;
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    double west = ((seed >> 33) % 360000) / 1000.0 - 180.0;
+    file << "A" << i << ",AIRPORT " << i << ",CITY " << i % 5000 << ",COUNTRY " << i % 200 << ","
+         << north << "," << west << endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int count = (argc > 1) ? atoi(argv[1]) : 100000;
+  double maxLeg = (argc > 2) ? atof(argv[2]) : 150.0;
+  string fileName = "/tmp/proj3_bench_" + to_string(getpid()) + ".txt";
+  WriteCatalog(fileName, count);
+
+#ifdef COMPACT_COORDS
+  cout << "Storage: compact (int32 microdegrees, float leg miles)" << endl;
+#else
+  cout << "Storage: double" << endl;
+#endif
+  cout << "sizeof(Airport) " << sizeof(Airport) << " bytes, sizeof(Leg) " << sizeof(Leg) << " bytes" << endl;
+
+  Navigator navigator(fileName);
+  auto start = chrono::steady_clock::now();
+  navigator.ReadFile();
+  cout << "Load: " << Seconds(start) << " s" << endl;
+  shared_ptr<Catalog> catalog = navigator.GetCatalog();
+  start = chrono::steady_clock::now();
+  catalog->BuildIndexes();
+  cout << "Indexes: " << Seconds(start) << " s (search " << catalog->GetSearchMillis() << " ms, grid "
+       << catalog->GetGridMillis() << " ms)" << endl;
+
+  // Startup: the same file loaded in the background. A code lookup only
+  // waits for the airports, the first search waits for its index too
+  {
+    Navigator background(fileName);
+    start = chrono::steady_clock::now();
+    background.StartLoading();
+    shared_ptr<Catalog> early = background.WaitForCatalog();
+    early->FindCode("A" + to_string(count / 2));
+    double firstLookup = Seconds(start);
+    early->Search("CITY 7", SEARCH_LIMIT);
+    cout << "Startup: first code lookup " << firstLookup * 1000 << " ms, first search " << Seconds(start) * 1000
+         << " ms after start" << endl;
+  }
+  remove(fileName.c_str());
+  navigator.DisplayMemory();
+
+  // Leg graph: the largest coordinate heavy table
+  LegGraph graph;
+  start = chrono::steady_clock::now();
+  navigator.BuildLegGraph(catalog, maxLeg, graph);
+  cout << "Leg graph (" << maxLeg << " mi): " << graph.GetLegCount() << " legs, "
+       << graph.GetLegCount() * sizeof(Leg) / 1048576.0 << " MB, built in " << Seconds(start) << " s" << endl;
+
+  // Scan every leg repeatedly, bound by memory bandwidth once the table is large
+  const int PASSES = 20;
+  double total = 0.0;
+  start = chrono::steady_clock::now();
+  for (int pass = 0; pass < PASSES; pass++)
+  {
+    for (int i = 0; i < graph.GetSize(); i++)
+    {
+      for (const Leg *leg = graph.Begin(i); leg != graph.End(i); ++leg)
+      {
+        total += leg->m_miles;
+      }
+    }
+  }
+  double scan = Seconds(start);
+  cout << "Leg scan: " << (double(graph.GetLegCount()) * PASSES / scan) / 1e6 << " M legs/s (checksum "
+       << total / PASSES << ")" << endl;
+
+  // Hubs: a sample of Brandes sources on the same graph, spread over threads
+  const int HUB_SAMPLES = 64;
+  int most = max(4, static_cast<int>(thread::hardware_concurrency()));
+  for (int threads = 1; threads <= most; threads *= 2)
+  {
+    CentralityOptions options;
+    options.m_threads = threads;
+    options.m_samples = HUB_SAMPLES;
+    Centrality centrality(&graph, options);
+    start = chrono::steady_clock::now();
+    centrality.Run();
+    vector<HubScore> top = centrality.Top(1, true);
+    cout << "Hubs x" << threads << ": " << HUB_SAMPLES / Seconds(start) << " sources/s (top "
+         << catalog->GetAirport(top[0].m_airport)->GetCode() << ")" << endl;
+  }
+
+  // Reachability: every airport as an origin, three hops, 64 origins a batch
+  const int REACH_HOPS = 3;
+  vector<int> origins(graph.GetSize());
+  for (int i = 0; i < graph.GetSize(); i++)
+  {
+    origins[i] = i;
+  }
+  for (int threads = 1; threads <= most; threads *= 2)
+  {
+    Reachability reachability(&graph, threads);
+    start = chrono::steady_clock::now();
+    vector<ReachResult> reached = reachability.Run(origins, REACH_HOPS, false);
+    long airports = 0;
+    for (size_t i = 0; i < reached.size(); i++)
+    {
+      for (int hop = 0; hop < REACH_HOPS; hop++)
+      {
+        airports += reached[i].m_counts[hop];
+      }
+    }
+    cout << "Reach x" << threads << ": " << origins.size() / Seconds(start) << " origins/s (" << REACH_HOPS
+         << " hops, " << double(airports) / origins.size() << " airports each)" << endl;
+  }
+
+  // Routes of five stops, scored repeatedly
+  const int ROUTES = 20000;
+  vector<Route *> routes;
+  vector<int> stops(5);
+  for (int i = 0; i < ROUTES; i++)
+  {
+    for (int j = 0; j < 5; j++)
+    {
+      stops[j] = (i * 7919 + j * 104729) % catalog->GetSize();
+    }
+    routes.push_back(navigator.BuildRoute(catalog, stops));
+  }
+  total = 0.0;
+  start = chrono::steady_clock::now();
+  for (int pass = 0; pass < 10; pass++)
+  {
+    for (int i = 0; i < ROUTES; i++)
+    {
+      total += navigator.RouteDistanceWith<DefaultDistance>(routes[i]); // the walk, not Route's cached total
+    }
+  }
+  cout << "RouteDistanceWith: " << (ROUTES * 10.0 / Seconds(start)) / 1e6 << " M routes/s (checksum "
+       << total / 10 << ")" << endl;
+  for (int i = 0; i < ROUTES; i++)
+  {
+    delete routes[i];
+  }
+
+  // Short routes built and scored on the stack: the stops stay inline
+  // in the Route, so the loop should not touch the heap at all
+  const int SHORT_ROUTES = 1000000;
+  total = 0.0;
+  long allocations = g_allocations;
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < SHORT_ROUTES; i++)
+  {
+    Route route;
+    for (int j = 0; j < 2 + i % 5; j++) // 2 to 6 stops
+    {
+      route.InsertEnd(*catalog->GetAirport((i * 7919LL + j * 104729LL) % catalog->GetSize()));
+    }
+    route.NameByCities();
+    total += route.GetMiles();
+  }
+  cout << "Short routes: " << (SHORT_ROUTES / Seconds(start)) / 1e6 << " M built and scored/s, "
+       << double(g_allocations - allocations) / SHORT_ROUTES << " heap allocations each (checksum "
+       << total / SHORT_ROUTES << ")" << endl;
+
+  // Similar routes: a million stored shapes of 2 to 6 stops, the ten
+  // nearest to some of them by thread count, then once refining every
+  // shape to show what the filter saves
+  const int SHAPES = 1000000;
+  const int SIMILAR_QUERIES = 20;
+  SimilarityIndex shapes;
+  vector<vector<double> > shapeNorth(SIMILAR_QUERIES), shapeWest(SIMILAR_QUERIES);
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < SHAPES; i++)
+  {
+    vector<double> north, west;
+    for (int j = 0; j < 2 + i % 5; j++)
+    {
+      Airport *airport = catalog->GetAirport((i * 7919LL + j * 104729LL) % catalog->GetSize());
+      north.push_back(airport->GetNorth());
+      west.push_back(airport->GetWest());
+    }
+    shapes.Add(north, west);
+    if (i < SIMILAR_QUERIES)
+    {
+      shapeNorth[i] = north;
+      shapeWest[i] = west;
+    }
+  }
+  cout << "Shapes: " << shapes.GetSize() << " routes (" << shapes.GetPointCount() << " stops) indexed in "
+       << Seconds(start) << " s" << endl;
+  for (int threads = 1; threads <= most; threads *= 2)
+  {
+    SimilarOptions options;
+    options.m_threads = threads;
+    options.m_count = SIMILAR_LIMIT;
+    options.m_maxMiles = 0.0;
+    for (int measure = 0; measure < 2; measure++)
+    {
+      options.m_measure = (measure == 0) ? SIMILAR_FRECHET : SIMILAR_DTW;
+      total = 0.0;
+      start = chrono::steady_clock::now();
+      for (int i = 0; i < SIMILAR_QUERIES; i++)
+      {
+        options.m_exclude = i;
+        total += shapes.Similar(shapeNorth[i], shapeWest[i], options).back().m_miles;
+      }
+      cout << "Similar x" << threads << " (" << (measure == 0 ? "frechet" : "dtw") << "): "
+           << Seconds(start) * 1000 / SIMILAR_QUERIES << " ms/query (tenth nearest " << total / SIMILAR_QUERIES
+           << " mi)" << endl;
+    }
+  }
+  SimilarOptions everything;
+  everything.m_threads = 1;
+  everything.m_count = SHAPES; // never fills up, so nothing is pruned
+  everything.m_measure = SIMILAR_FRECHET;
+  everything.m_maxMiles = 0.0;
+  everything.m_exclude = 0;
+  start = chrono::steady_clock::now();
+  shapes.Similar(shapeNorth[0], shapeWest[0], everything);
+  cout << "Similar, every shape refined: " << Seconds(start) * 1000 << " ms/query" << endl;
+
+  // Clustering: k-means over the whole catalog by thread count, then
+  // density clustering with the grid doing the neighbour searches
+  for (int threads = 1; threads <= most; threads *= 2)
+  {
+    vector<double> north(catalog->GetSize()), west(catalog->GetSize());
+    for (int i = 0; i < catalog->GetSize(); i++)
+    {
+      north[i] = catalog->GetAirport(i)->GetNorth();
+      west[i] = catalog->GetAirport(i)->GetWest();
+    }
+    ClusterOptions options;
+    options.m_threads = threads;
+    options.m_maxIterations = CLUSTER_ITERATIONS;
+    options.m_seed = 1;
+    Clustering clustering(north, west, options);
+    start = chrono::steady_clock::now();
+    Clusters clusters = clustering.KMeans(64);
+    cout << "K-means x" << threads << " (k 64): " << Seconds(start) << " s, " << clusters.m_iterations << " rounds"
+         << endl;
+  }
+  start = chrono::steady_clock::now();
+  Clusters dense = navigator.ClusterCatalog(catalog, 0, 0, maxLeg / 2, 8);
+  cout << "DBSCAN (" << maxLeg / 2 << " mi, 8 points): " << Seconds(start) << " s, " << dense.m_sizes.size()
+       << " clusters" << endl;
+
+  // Timetable: a million flights over a week between 2000 airports,
+  // sorted once, then earliest arrival and profile queries
+  const int FLIGHTS = 1000000;
+  const int TIMETABLE_AIRPORTS = 2000;
+  stringstream flights;
+  flights << "MCT,*,45\n";
+  unsigned long long seed = 777;
+  for (int i = 0; i < FLIGHTS; i++)
+  {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    int from = (seed >> 33) % TIMETABLE_AIRPORTS;
+    int to = (from + 1 + (seed >> 45) % (TIMETABLE_AIRPORTS - 1)) % TIMETABLE_AIRPORTS;
+    int departure = (seed >> 20) % (7 * 24 * 60);
+    flights << "A" << from << ",A" << to << "," << departure << "," << departure + 60 + (seed >> 50) % 300 << "\n";
+  }
+  Timetable timetable;
+  start = chrono::steady_clock::now();
+  timetable.Load(flights);
+  cout << "Timetable: " << timetable.GetConnectionCount() << " flights sorted in " << Seconds(start) << " s" << endl;
+  const int QUERIES = 200;
+  int reached = 0;
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < QUERIES; i++)
+  {
+    Journey journey;
+    reached += timetable.EarliestArrival("A" + to_string(i), "A" + to_string(1999 - i), (i * 97) % (6 * 24 * 60), journey);
+  }
+  cout << "Earliest arrival: " << Seconds(start) * 1000 / QUERIES << " ms/query (" << reached << " of " << QUERIES
+       << " reached)" << endl;
+  long journeys = 0;
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++)
+  {
+    journeys += timetable.Profile("A" + to_string(i), "A" + to_string(1999 - i), 24 * 60, 2 * 24 * 60).size();
+  }
+  cout << "Profile (one day of departures): " << Seconds(start) * 1000 / 10 << " ms/query (" << journeys / 10.0
+       << " journeys each)" << endl;
+
+  // Sessions: every thread runs its own session (private routes) on the
+  // shared catalog, throughput should grow with the thread count
+  const int SCRIPT_REPEATS = 300;
+  ostringstream script;
+  for (int i = 0; i < SCRIPT_REPEATS; i++)
+  {
+    int first = (i * 7919) % catalog->GetSize();
+    script << "route A" << first << " A" << (first + 1) % catalog->GetSize() << " A" << (first + 2) % catalog->GetSize() << "\n"
+           << "search CITY " << i % 5000 << "\n"
+           << "near A" << first << " 50\n"
+           << "routes\n"
+           << "delete 1\n";
+  }
+  int commands = SCRIPT_REPEATS * 5;
+  for (int threads = 1; threads <= most; threads *= 2)
+  {
+    vector<thread> workers;
+    start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+      workers.push_back(thread([&navigator, &script]() {
+        ostringstream output;
+        Navigator session(&navigator, &output);
+        istringstream input(script.str());
+        session.RunBatch(input);
+      }));
+    }
+    for (int t = 0; t < threads; t++)
+    {
+      workers[t].join();
+    }
+    cout << "Sessions x" << threads << ": " << commands * threads / Seconds(start) << " commands/s" << endl;
+  }
+  return 0;
+}